@@ -0,0 +1,517 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "inventory.h"
+#include "item.h"
+#include "item_scan.h"
+#include "item_sorter.h"
+#include "journal.h"
+#include "number_parser.h"
+#include "table_writer.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Runs inventory commands without prompts, one command per line:
+//
+//   add <id> <quantity> <price> <category> <name...>
+//   quantity <id> <quantity>
+//   adjust <id> <change>             (e.g. -3 after selling three)
+//   price <id> <price>
+//   remove <id>
+//   search <id>
+//   list [<category>]
+//   sort <quantity|price|category> [asc|desc] ...   (most significant first)
+//   top <quantity|price> <asc|desc> <count>
+//   low
+//   count
+//   find [category <n>] [quantity <min> <max>] [price <min> <max>] [name <text...>]
+//   total [<conditions as for find>]
+//   stats [reset]
+//
+// find lists the items matching every condition given, in stored order;
+// a bound of - leaves that end of a range open, and name (which takes the
+// rest of the line) matches any part of the name, ignoring case. total
+// gives their total quantity and stock value (quantity times price).
+// stats reports the call count and latencies of each operation run so far
+// (see OperationStats), one stat line per operation that has been called;
+// stats reset starts the counts over.
+//
+// Words are separated by spaces or tabs; the name is the rest of the line.
+// Blank lines and lines starting with # are skipped. Values are checked
+// with the same rules as the menu.
+//
+// Each command gets one status line, after any item lines it lists:
+//
+//   item <id> <name> <quantity> <price> <category name>
+//   total <quantity> <value>
+//   stat <operation> <calls> <mean ns> <p50 ns> <p90 ns> <p99 ns> <p99.9 ns> <max ns>
+//   ok [<count>]
+//   error <message>
+//
+// Fields are tab-separated; tabs, newlines and backslashes in names are
+// written as \t, \n and \\. Output is buffered and flushed only when the
+// input has no more data ready, so a tool can pipeline requests. With a
+// journal attached, changes are committed before any output is handed to the
+// sink (when the buffer fills as well as at each flush), so every
+// acknowledged change is durable. If a commit fails, the output waiting on
+// it is dropped and the run stops with the error on stderr, so no change
+// that is not durable is ever acknowledged.
+
+struct BatchReport {
+    uint64_t commands = 0;
+    uint64_t errors = 0;
+    double seconds = 0;
+
+    double commandsPerSecond() const { return seconds > 0 ? commands / seconds : 0; }
+};
+
+class BatchRunner {
+private:
+    struct Word {
+        const char* text;
+        size_t length;
+
+        bool is(const char* literal) const {
+            return length == std::strlen(literal) && std::memcmp(text, literal, length) == 0;
+        }
+    };
+
+    // Hands output on only after committing the journal, so no
+    // acknowledgment leaves before its change is durable, even when the
+    // writer's buffer fills in the middle of a command
+    class DurableSink : public OutputSink {
+    private:
+        BatchRunner& runner;
+        OutputSink& sink;
+
+    public:
+        DurableSink(BatchRunner& runner, OutputSink& sink) : runner(runner), sink(sink) {}
+
+        void write(const char* data, size_t size) override {
+            if (runner.commitJournal()) sink.write(data, size);
+        }
+
+        void flush() override {
+            if (runner.commitJournal()) sink.flush();
+        }
+    };
+
+    Inventory& inventory;
+    DurableSink durable;
+    TableWriter out;
+    ItemSorter sorter;
+    ItemScanner scanner;
+    Journal* journal = nullptr;
+    std::string dataPath;
+    std::string error;
+
+    std::vector<char> input;
+    size_t start = 0; // unread input is [start, filled)
+    size_t filled = 0;
+    bool inputError = false;
+    bool journalFailed = false;
+
+    // False once a commit has failed; the run then stops
+    bool commitJournal() {
+        if (journal == nullptr) return true;
+        if (journalFailed) return false;
+        if (!journal->commit()) {
+            std::fprintf(stderr, "Journal write failed: %s\n", journal->error().c_str());
+            journalFailed = true;
+            return false;
+        }
+        if (journal->needsCompaction() && !compactJournal(inventory, dataPath, *journal, error)) {
+            std::fprintf(stderr, "Journal compaction failed: %s\n", error.c_str());
+        }
+        return true;
+    }
+
+    // Hand output over (committing the journal first) before waiting for input
+    void beforeWait() { out.flush(); }
+
+    // Next input line without its line ending; false at end of input
+    bool readLine(int fd, const char*& line, size_t& length) {
+        while (true) {
+            char* begin = input.data() + start;
+            char* newline = static_cast<char*>(std::memchr(begin, '\n', filled - start));
+            if (newline != nullptr) {
+                line = begin;
+                length = static_cast<size_t>(newline - begin);
+                start += length + 1;
+                break;
+            }
+            // Keep the partial line, growing the buffer if it fills it
+            std::memmove(input.data(), begin, filled - start);
+            filled -= start;
+            start = 0;
+            if (filled == input.size()) input.resize(input.size() * 2);
+
+            beforeWait();
+            if (journalFailed) return false;
+#ifdef _WIN32
+            int got = _read(fd, input.data() + filled, static_cast<unsigned>(input.size() - filled));
+#else
+            ssize_t got = ::read(fd, input.data() + filled, input.size() - filled);
+#endif
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                inputError = got < 0;
+                if (filled == 0) return false;
+                // Last line without a newline
+                line = input.data();
+                length = filled;
+                start = filled;
+                break;
+            }
+            filled += static_cast<size_t>(got);
+        }
+        if (length > 0 && line[length - 1] == '\r') --length;
+        return true;
+    }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+    static Word nextWord(const char*& p, const char* end) {
+        while (p < end && isSpace(*p)) ++p;
+        const char* begin = p;
+        while (p < end && !isSpace(*p)) ++p;
+        return Word{begin, static_cast<size_t>(p - begin)};
+    }
+
+    void field(const char* text, size_t length) {
+        out.text("\t");
+        size_t run = 0;
+        for (size_t i = 0; i < length; ++i) {
+            const char* escape = text[i] == '\t' ? "\\t" : text[i] == '\n' ? "\\n" : text[i] == '\r' ? "\\r"
+                               : text[i] == '\\' ? "\\\\" : nullptr;
+            if (escape == nullptr) continue;
+            out.text(text + run, i - run);
+            out.text(escape, 2);
+            run = i + 1;
+        }
+        out.text(text + run, length - run);
+    }
+
+    void item(const Item& value) {
+        TextView id = value.getId();
+        TextView name = value.getName();
+        out.text("item");
+        field(id.data(), id.length());
+        field(name.data(), name.length());
+        out.text("\t");
+        out.cell(value.getQuantity(), 0);
+        out.text("\t");
+        out.number(value.getPrice());
+        out.text("\t");
+        out.text(value.getCategoryName());
+        out.endRow();
+    }
+
+    void ok() { out.line("ok"); }
+
+    void ok(size_t count) {
+        out.text("ok\t");
+        out.cell(static_cast<long long>(count), 0);
+        out.endRow();
+    }
+
+    bool fail(const char* message) {
+        out.text("error\t");
+        out.line(message);
+        return false;
+    }
+
+    bool status(UpdateStatus result) {
+        if (result != UpdateStatus::Ok) return fail(updateStatusMessage(result));
+        ok();
+        return true;
+    }
+
+    // The item ID and, for add/quantity/price, the checked values
+    bool readId(const char*& p, const char* end, Word& id) {
+        id = nextWord(p, end);
+        return validItemId(id.text, id.length) || fail("invalid item ID");
+    }
+
+    // New items need a positive quantity, as in the menu; the quantity
+    // command may also set it to zero, as setQuantity allows
+    bool readQuantity(const char*& p, const char* end, int& quantity, bool allowZero) {
+        Word word = nextWord(p, end);
+        bool valid = parseInt(word.text, word.text + word.length, quantity) &&
+                     (quantity > 0 || (allowZero && quantity == 0));
+        return valid ||
+               fail(allowZero ? "quantity must be a non-negative integer" : "quantity must be a positive integer");
+    }
+
+    bool readPrice(const char*& p, const char* end, double& price) {
+        Word word = nextWord(p, end);
+        return (parseDouble(word.text, word.text + word.length, price) && price > 0) ||
+               fail("price must be a positive number");
+    }
+
+    bool readCategory(Word word, int& category) {
+        return (parseInt(word.text, word.text + word.length, category) && category >= 1 &&
+                category <= categoryCount) || fail("category must be 1, 2 or 3");
+    }
+
+    bool readEnd(const char*& p, const char* end) {
+        return nextWord(p, end).length == 0 || fail("too many arguments");
+    }
+
+    bool readSortField(Word word, SortField& sortField) {
+        if (word.is("quantity")) sortField = SortField::Quantity;
+        else if (word.is("price")) sortField = SortField::Price;
+        else if (word.is("category")) sortField = SortField::Category;
+        else return fail("sort field must be quantity, price or category");
+        return true;
+    }
+
+    // One end of a find range; - leaves it as it was
+    template <typename T>
+    bool readBound(const char*& p, const char* end, T& bound) {
+        Word word = nextWord(p, end);
+        return word.is("-") || parseNumber(word.text, word.text + word.length, bound) ||
+               fail("range bounds must be numbers or -");
+    }
+
+    static bool parseNumber(const char* first, const char* last, int& value) { return parseInt(first, last, value); }
+    static bool parseNumber(const char* first, const char* last, double& value) {
+        return parseDouble(first, last, value);
+    }
+
+    bool readQuery(const char*& p, const char* end, ItemQuery& query) {
+        for (Word word = nextWord(p, end); word.length > 0; word = nextWord(p, end)) {
+            if (word.is("category")) {
+                if (!readCategory(nextWord(p, end), query.category)) return false;
+            } else if (word.is("quantity")) {
+                if (!readBound(p, end, query.minQuantity) || !readBound(p, end, query.maxQuantity)) return false;
+            } else if (word.is("price")) {
+                if (!readBound(p, end, query.minPrice) || !readBound(p, end, query.maxPrice)) return false;
+            } else if (word.is("name")) {
+                while (p < end && isSpace(*p)) ++p;
+                query.nameContains.assign(p, end);
+                p = end;
+            } else {
+                return fail("find conditions are category, quantity, price and name");
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    void listIndex(const SortedIndex<T>& index, bool ascending, size_t limit) {
+        const ItemStore& items = inventory.getItems();
+        size_t listed = 0;
+        if (ascending) {
+            for (typename SortedIndex<T>::const_iterator it = index.begin(); it != index.end() && listed < limit;
+                 ++it, ++listed) {
+                item(*items.get(it->handle));
+            }
+        } else {
+            for (typename SortedIndex<T>::const_reverse_iterator it = index.rbegin();
+                 it != index.rend() && listed < limit; ++it, ++listed) {
+                item(*items.get(it->handle));
+            }
+        }
+        ok(listed);
+    }
+
+    void listStats() {
+        size_t listed = 0;
+        for (size_t op = 0; op < operationCount; ++op) {
+            OperationSummary summary = OperationStats::summary(static_cast<Operation>(op));
+            if (summary.calls == 0) continue;
+            const uint64_t values[] = {summary.calls, summary.meanNs(), summary.percentileNs(0.5),
+                                       summary.percentileNs(0.9), summary.percentileNs(0.99),
+                                       summary.percentileNs(0.999), summary.maxNs()};
+            out.text("stat\t");
+            out.text(operationName(static_cast<Operation>(op)));
+            for (uint64_t value : values) {
+                out.text("\t");
+                out.cell(static_cast<long long>(value), 0);
+            }
+            out.endRow();
+            ++listed;
+        }
+        ok(listed);
+    }
+
+    // Run one command; false if it failed
+    bool execute(const char* p, const char* end) {
+        Word command = nextWord(p, end);
+        Word id;
+        int quantity, category;
+        double price;
+        const ItemStore& items = inventory.getItems();
+
+        if (command.is("add")) {
+            if (!readId(p, end, id) || !readQuantity(p, end, quantity, false) || !readPrice(p, end, price) ||
+                !readCategory(nextWord(p, end), category)) {
+                return false;
+            }
+            while (p < end && isSpace(*p)) ++p;
+            if (!inventory.insertItem(Item(TextView(id.text, id.length), TextView(p, static_cast<size_t>(end - p)), quantity, price,
+                                           static_cast<Category>(category)))) {
+                return fail("item ID already exists");
+            }
+            ok();
+        } else if (command.is("quantity")) {
+            if (!readId(p, end, id) || !readQuantity(p, end, quantity, true) || !readEnd(p, end)) return false;
+            return status(inventory.setQuantity(TextView(id.text, id.length), quantity));
+        } else if (command.is("adjust")) {
+            if (!readId(p, end, id)) return false;
+            Word delta = nextWord(p, end);
+            if (!parseInt(delta.text, delta.text + delta.length, quantity)) return fail("change must be an integer");
+            if (!readEnd(p, end)) return false;
+            return status(inventory.adjustQuantity(TextView(id.text, id.length), quantity));
+        } else if (command.is("price")) {
+            if (!readId(p, end, id) || !readPrice(p, end, price) || !readEnd(p, end)) return false;
+            return status(inventory.setPrice(TextView(id.text, id.length), price));
+        } else if (command.is("remove")) {
+            if (!readId(p, end, id) || !readEnd(p, end)) return false;
+            if (!inventory.eraseItem(TextView(id.text, id.length))) return fail("item not found");
+            ok();
+        } else if (command.is("search")) {
+            if (!readId(p, end, id) || !readEnd(p, end)) return false;
+            TIME_OPERATION(Operation::Search);
+            const Item* found = inventory.getItem(TextView(id.text, id.length));
+            if (found == nullptr) return fail("item not found");
+            item(*found);
+            ok(1);
+        } else if (command.is("list")) {
+            Word word = nextWord(p, end);
+            if (word.length == 0) {
+                TIME_OPERATION(Operation::ListAll);
+                for (const Item& value : items) item(value);
+                ok(items.size());
+                return true;
+            }
+            if (!readCategory(word, category) || !readEnd(p, end)) return false;
+            TIME_OPERATION(Operation::ListCategory);
+            const std::vector<ItemHandle>& members = inventory.getCategoryMembers(static_cast<Category>(category));
+            for (ItemHandle handle : members) item(*items.get(handle));
+            ok(members.size());
+        } else if (command.is("sort")) {
+            std::vector<SortKey> keys;
+            for (Word word = nextWord(p, end); word.length > 0;) {
+                SortKey key{SortField::Quantity, true};
+                if (!readSortField(word, key.field)) return false;
+                word = nextWord(p, end);
+                if (word.is("asc") || word.is("desc")) {
+                    key.ascending = word.is("asc");
+                    word = nextWord(p, end);
+                }
+                keys.push_back(key);
+            }
+            if (keys.empty()) return fail("sort needs a field");
+            TIME_OPERATION(Operation::Sort);
+            for (uint32_t position : sorter.order(items, keys.data(), keys.size())) item(items[position]);
+            ok(items.size());
+        } else if (command.is("top")) {
+            SortField sortField;
+            Word direction;
+            Word limit;
+            int count;
+            if (!readSortField(nextWord(p, end), sortField)) return false;
+            direction = nextWord(p, end);
+            if (sortField == SortField::Category || !(direction.is("asc") || direction.is("desc"))) {
+                return fail("usage: top <quantity|price> <asc|desc> <count>");
+            }
+            limit = nextWord(p, end);
+            if (!parseInt(limit.text, limit.text + limit.length, count) || count < 0) {
+                return fail("count must be a non-negative integer");
+            }
+            if (!readEnd(p, end)) return false;
+            TIME_OPERATION(Operation::Sort);
+            if (sortField == SortField::Quantity) {
+                listIndex(inventory.getQuantityIndex(), direction.is("asc"), static_cast<size_t>(count));
+            } else {
+                listIndex(inventory.getPriceIndex(), direction.is("asc"), static_cast<size_t>(count));
+            }
+        } else if (command.is("low")) {
+            if (!readEnd(p, end)) return false;
+            TIME_OPERATION(Operation::LowStock);
+            const std::vector<ItemHandle>& members = inventory.getLowStockMembers();
+            for (ItemHandle handle : members) item(*items.get(handle));
+            ok(members.size());
+        } else if (command.is("find")) {
+            ItemQuery query;
+            if (!readQuery(p, end, query)) return false;
+            TIME_OPERATION(Operation::Find);
+            std::vector<uint32_t> matches = scanner.find(items, query);
+            for (uint32_t position : matches) item(items[position]);
+            ok(matches.size());
+        } else if (command.is("total")) {
+            ItemQuery query;
+            if (!readQuery(p, end, query)) return false;
+            TIME_OPERATION(Operation::Find);
+            ItemTotals totals = scanner.totals(items, query);
+            out.text("total\t");
+            out.cell(totals.quantity, 0);
+            out.text("\t");
+            out.number(totals.value);
+            out.endRow();
+            ok(totals.items);
+        } else if (command.is("count")) {
+            if (!readEnd(p, end)) return false;
+            ok(items.size());
+        } else if (command.is("stats")) {
+            Word word = nextWord(p, end);
+            if (!(word.length == 0 || word.is("reset")) || !readEnd(p, end)) return fail("usage: stats [reset]");
+            if (!OperationStats::enabled()) return fail("statistics are not recorded in this build");
+            if (word.is("reset")) {
+                OperationStats::reset();
+                ok();
+            } else {
+                listStats();
+            }
+        } else {
+            return fail("unknown command");
+        }
+        return true;
+    }
+
+public:
+    BatchRunner(Inventory& inventory, OutputSink& sink)
+        : inventory(inventory), durable(*this, sink), out(durable, 1 << 20), input(1 << 20) {}
+
+    // Commit journal (and compact it into dataPath) before output is flushed
+    void setJournal(Journal* newJournal, const std::string& newDataPath) {
+        journal = newJournal;
+        dataPath = newDataPath;
+    }
+
+    // Run every command read from fd; false if reading failed or a journal
+    // commit failed, which ends the run early
+    bool run(int fd, BatchReport& report) {
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        report = BatchReport();
+        const char* line;
+        size_t length;
+        while (!journalFailed && readLine(fd, line, length)) {
+            const char* p = line;
+            const char* end = line + length;
+            while (p < end && isSpace(*p)) ++p;
+            if (p == end || *p == '#') continue;
+            ++report.commands;
+            if (!execute(p, end)) ++report.errors;
+        }
+        beforeWait();
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return !inputError && !journalFailed;
+    }
+};
+
+#endif
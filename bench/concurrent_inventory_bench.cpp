@@ -0,0 +1,131 @@
+// Read/write mix against ConcurrentInventory at increasing thread counts.
+//
+// Each thread looks up random items (copying them out, as searchItem does)
+// and, for writePercent of its operations, adjusts a random item's
+// quantity. Every thread count is run with the sharded inventory and with
+// a single shard (one global reader/writer lock) for comparison.
+//
+// usage: concurrent_inventory_bench [--items N] [--seconds S] [--shards K]
+//                                   [--threads T] [--write-percent W]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_inventory.h"
+
+struct Options {
+    size_t items = 1000000;
+    double seconds = 2;
+    size_t shards = 64;
+    unsigned threads = 0;
+    unsigned writePercent = 5;
+};
+
+struct Result {
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    double seconds = 0;
+
+    double opsPerSecond() const { return (reads + writes) / seconds; }
+};
+
+static Result run(ConcurrentInventory& inventory, const std::vector<std::string>& ids, const Options& options,
+                  unsigned threadCount) {
+    std::atomic<bool> stop(false);
+    std::vector<Result> results(threadCount);
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+            Item copy("", "", 0, 0, Category::Clothing);
+            Result local;
+            while (!stop.load(std::memory_order_relaxed)) {
+                // a batch between checks of the stop flag
+                for (int i = 0; i < 256; ++i) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    const std::string& id = ids[state % ids.size()];
+                    if ((state >> 40) % 100 < options.writePercent) {
+                        inventory.adjustQuantity(id, (state >> 20) & 1 ? 1 : -1);
+                        ++local.writes;
+                    } else {
+                        inventory.getItem(id, copy);
+                        ++local.reads;
+                    }
+                }
+            }
+            results[t] = local;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop = true;
+    for (std::thread& thread : threads) thread.join();
+
+    Result total;
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (const Result& result : results) {
+        total.reads += result.reads;
+        total.writes += result.writes;
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--items") == 0) options.items = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--seconds") == 0) options.seconds = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--shards") == 0) options.shards = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--threads") == 0) options.threads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--write-percent") == 0) options.writePercent = std::atoi(argv[i + 1]);
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (options.threads == 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (options.items == 0) options.items = 1;
+
+    std::vector<std::string> ids;
+    ids.reserve(options.items);
+    for (size_t i = 0; i < options.items; ++i) ids.push_back("SKU" + std::to_string(i));
+
+    ConcurrentInventory sharded(options.shards);
+    ConcurrentInventory global(1);
+    for (size_t i = 0; i < options.items; ++i) {
+        Item item(ids[i], "Item " + std::to_string(i), 1000, 1.0 + i % 1000, static_cast<Category>(1 + i % 3));
+        sharded.insertItem(item);
+        global.insertItem(item);
+    }
+
+    std::printf("%zu items, %u%% writes, %.1fs per run, %u hardware threads\n\n", options.items,
+                options.writePercent, options.seconds, std::thread::hardware_concurrency());
+    std::printf("%-8s %-8s %14s %14s %9s\n", "threads", "shards", "ops/sec", "reads/sec", "speedup");
+
+    double shardedBase = 0;
+    double globalBase = 0;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, options.threads)) {
+        Result a = run(sharded, ids, options, threads);
+        Result b = run(global, ids, options, threads);
+        if (threads == 1) {
+            shardedBase = a.opsPerSecond();
+            globalBase = b.opsPerSecond();
+        }
+        std::printf("%-8u %-8zu %14.0f %14.0f %8.2fx\n", threads, sharded.shardCount(), a.opsPerSecond(),
+                    a.reads / a.seconds, a.opsPerSecond() / shardedBase);
+        std::printf("%-8u %-8zu %14.0f %14.0f %8.2fx\n", threads, global.shardCount(), b.opsPerSecond(),
+                    b.reads / b.seconds, b.opsPerSecond() / globalBase);
+        if (threads == options.threads) break;
+    }
+    return 0;
+}
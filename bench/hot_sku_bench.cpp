@@ -0,0 +1,201 @@
+// Contention on a few hot items: lock-free counters against the shard lock.
+//
+// Every thread reserves and releases stock (adjustQuantity by -1 or +1) on
+// randomly chosen items from a small hot set, the pattern of a flash sale.
+// Each thread count is run with the hot items left as ordinary items, so
+// every adjustment takes its shard's write lock, and again with the items
+// marked hot, so adjustments are a CAS on a QuantityCounter. After each run
+// the item quantities are checked against the adjustments that succeeded.
+//
+// A second table has each thread adjust a counter of its own, with the
+// counters packed into one array and then padded to a cache line each, to
+// show the cost of false sharing that the padding avoids.
+//
+// usage: hot_sku_bench [--items N] [--hot H] [--stock Q] [--seconds S]
+//                      [--threads T]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_inventory.h"
+#include "quantity_counter.h"
+
+struct Options {
+    size_t items = 100000;
+    size_t hot = 4;
+    int stock = 100;
+    double seconds = 1;
+    unsigned threads = 0;
+};
+
+struct Result {
+    uint64_t operations = 0;
+    uint64_t refused = 0; // reservations that would have gone below zero
+    double seconds = 0;
+
+    double opsPerSecond() const { return operations / seconds; }
+};
+
+static uint64_t nextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Run body(thread, local result) on threadCount threads until the time is up
+template <typename Body>
+static Result run(const Options& options, unsigned threadCount, Body body) {
+    std::atomic<bool> stop(false);
+    std::vector<Result> results(threadCount);
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            Result local;
+            while (!stop.load(std::memory_order_relaxed)) body(t, local);
+            results[t] = local;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop = true;
+    for (std::thread& thread : threads) thread.join();
+
+    Result total;
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (const Result& result : results) {
+        total.operations += result.operations;
+        total.refused += result.refused;
+    }
+    return total;
+}
+
+static Result runInventory(ConcurrentInventory& inventory, const std::vector<std::string>& hot,
+                           const Options& options, unsigned threadCount, bool& consistent) {
+    // net[t * hot.size() + h]: successful adjustments of hot item h by thread t
+    std::vector<long long> net(threadCount * hot.size());
+    std::vector<int> before(hot.size());
+    Item copy("", "", 0, 0, Category::Clothing);
+    for (size_t h = 0; h < hot.size(); ++h) {
+        inventory.getItem(hot[h], copy);
+        before[h] = copy.getQuantity();
+    }
+
+    Result result = run(options, threadCount, [&](unsigned t, Result& local) {
+        uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1) + local.operations;
+        for (int i = 0; i < 256; ++i) {
+            uint64_t random = nextRandom(state);
+            size_t h = random % hot.size();
+            int delta = (random >> 32) & 1 ? 1 : -1;
+            if (inventory.adjustQuantity(hot[h], delta) == UpdateStatus::Ok) {
+                net[t * hot.size() + h] += delta;
+            } else {
+                ++local.refused;
+            }
+            ++local.operations;
+        }
+    });
+
+    for (size_t h = 0; h < hot.size(); ++h) {
+        long long expected = before[h];
+        for (unsigned t = 0; t < threadCount; ++t) expected += net[t * hot.size() + h];
+        inventory.getItem(hot[h], copy);
+        if (copy.getQuantity() != expected || copy.getQuantity() < 0) consistent = false;
+    }
+    return result;
+}
+
+// The CAS loop of QuantityCounter::adjust on an unpadded atomic
+static bool adjustPacked(std::atomic<int>& value, int delta) {
+    int current = value.load(std::memory_order_relaxed);
+    while (current + delta >= 0) {
+        if (value.compare_exchange_weak(current, current + delta, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--items") == 0) options.items = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--hot") == 0) options.hot = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--stock") == 0) options.stock = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--seconds") == 0) options.seconds = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--threads") == 0) options.threads = std::atoi(argv[i + 1]);
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (options.threads == 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.items = std::max<size_t>(options.items, 1);
+    options.hot = std::min(std::max<size_t>(options.hot, 1), options.items);
+
+    std::vector<std::string> hot;
+    ConcurrentInventory inventory;
+    for (size_t i = 0; i < options.items; ++i) {
+        std::string id = "SKU" + std::to_string(i);
+        int stock = i < options.hot ? options.stock : 1000;
+        inventory.insertItem(Item(id, "Item " + std::to_string(i), stock, 1.0 + i % 1000,
+                                  static_cast<Category>(1 + i % 3)));
+        if (i < options.hot) hot.push_back(id);
+    }
+
+    std::printf("%zu items, %zu hot with %d in stock, %.1fs per run, %u hardware threads\n\n", options.items,
+                options.hot, options.stock, options.seconds, std::thread::hardware_concurrency());
+    std::printf("%-8s %-8s %14s %9s %9s\n", "threads", "path", "adjusts/sec", "refused", "speedup");
+
+    bool consistent = true;
+    double lockedBase = 0;
+    double atomicBase = 0;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, options.threads)) {
+        for (const std::string& id : hot) inventory.unmarkHot(id);
+        Result locked = runInventory(inventory, hot, options, threads, consistent);
+        for (const std::string& id : hot) inventory.markHot(id);
+        Result atomic = runInventory(inventory, hot, options, threads, consistent);
+        if (threads == 1) {
+            lockedBase = locked.opsPerSecond();
+            atomicBase = atomic.opsPerSecond();
+        }
+        std::printf("%-8u %-8s %14.0f %8.1f%% %8.2fx\n", threads, "locked", locked.opsPerSecond(),
+                    100.0 * locked.refused / locked.operations, locked.opsPerSecond() / lockedBase);
+        std::printf("%-8u %-8s %14.0f %8.1f%% %8.2fx\n", threads, "atomic", atomic.opsPerSecond(),
+                    100.0 * atomic.refused / atomic.operations, atomic.opsPerSecond() / atomicBase);
+        if (threads == options.threads) break;
+    }
+    std::printf("\nquantities %s the successful adjustments\n", consistent ? "match" : "DO NOT match");
+
+    std::printf("\n%-8s %-8s %14s\n", "threads", "layout", "adjusts/sec");
+    for (unsigned threads = 1;; threads = std::min(threads * 2, options.threads)) {
+        std::unique_ptr<std::atomic<int>[]> packed(new std::atomic<int>[threads]);
+        for (unsigned t = 0; t < threads; ++t) packed[t] = options.stock;
+        Result a = run(options, threads, [&](unsigned t, Result& local) {
+            for (int i = 0; i < 256; ++i) adjustPacked(packed[t], i & 1 ? 1 : -1);
+            local.operations += 256;
+        });
+
+        std::vector<std::unique_ptr<QuantityCounter>> padded;
+        for (unsigned t = 0; t < threads; ++t) padded.emplace_back(new QuantityCounter(options.stock));
+        Result b = run(options, threads, [&](unsigned t, Result& local) {
+            int quantity;
+            for (int i = 0; i < 256; ++i) padded[t]->adjust(i & 1 ? 1 : -1, quantity);
+            local.operations += 256;
+        });
+        std::printf("%-8u %-8s %14.0f\n", threads, "packed", a.opsPerSecond());
+        std::printf("%-8u %-8s %14.0f\n", threads, "padded", b.opsPerSecond());
+        if (threads == options.threads) break;
+    }
+    return consistent ? 0 : 1;
+}
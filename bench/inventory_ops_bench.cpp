@@ -0,0 +1,345 @@
+// Latency and throughput of every Inventory operation at several sizes.
+//
+// For each inventory size it generates items with the requested category
+// and quantity distributions. The items are added one by one through
+// addItem, and each call is timed. It then times the other operations
+// through the same interface the menu uses:
+//
+//   add          addItem, while the inventory is built
+//   search       searchItem of a random existing ID
+//   set quantity setQuantity of a random item
+//   remove       removeItem of a random item (the item is added back,
+//                untimed, before the next one)
+//   category     displayItemsByCategory, cycling through the categories
+//   sort         sortItems by quantity or price, either direction
+//   sort keys    sortItems by category, then price descending
+//   top 10       displayTopItems, 10 items by quantity
+//   low stock    displayLowStockItems
+//
+// Listings are written to a sink that discards them, so they cost their
+// formatting but no I/O. Each operation runs until it has --samples samples
+// or has used --seconds, whichever comes first (at least one sample). The
+// report gives throughput and latency percentiles per operation.
+//
+// usage: inventory_ops_bench [--sizes N,N,...] [--categories W1,W2,W3]
+//                            [--quantity uniform:MAX|exponential:MEAN]
+//                            [--samples S] [--seconds T] [--seed X]
+//
+// Sizes default to 10^3 through 10^6; 10^7 needs about 1.5 GB, e.g.
+// --sizes 10000000. Category weights default to 1,1,1 and quantities to
+// uniform:1000. Items at or below quantity 5 are low stock.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <streambuf>
+#include <vector>
+
+#include "inventory.h"
+
+struct Options {
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    double categoryWeights[3] = {1, 1, 1};
+    bool exponential = false;
+    double quantityScale = 1000; // upper bound, or mean when exponential
+    size_t samples = 100000;
+    double seconds = 1;
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+};
+
+class NullSink : public OutputSink {
+public:
+    void write(const char*, size_t) override {}
+};
+
+// Swallows the status lines the menu operations print
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+class Generator {
+private:
+    const Options& options;
+    uint64_t state;
+
+public:
+    Generator(const Options& options) : options(options), state(options.seed) {}
+
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // Uniform in [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+
+    int category() {
+        double total = options.categoryWeights[0] + options.categoryWeights[1] + options.categoryWeights[2];
+        double pick = unit() * total;
+        if (pick < options.categoryWeights[0]) return 1;
+        if (pick < options.categoryWeights[0] + options.categoryWeights[1]) return 2;
+        return 3;
+    }
+
+    int quantity() {
+        double value = options.exponential ? -options.quantityScale * std::log(1 - unit())
+                                           : std::floor(unit() * (options.quantityScale + 1));
+        return value < std::numeric_limits<int>::max() ? static_cast<int>(value) : std::numeric_limits<int>::max();
+    }
+
+    double price() { return 1 + below(99900) / 100.0; }
+};
+
+static void formatId(char* id, size_t size, size_t number) {
+    std::snprintf(id, size, "SKU%zu", number);
+}
+
+static void formatName(char* name, size_t size, size_t number) {
+    std::snprintf(name, size, "Item %zu", number);
+}
+
+// Samples of one operation, in nanoseconds
+class Latencies {
+private:
+    std::vector<uint64_t> samples;
+    double total = 0;
+
+public:
+    void reserve(size_t count) { samples.reserve(count); }
+
+    void add(std::chrono::steady_clock::duration elapsed) {
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        samples.push_back(ns);
+        total += ns;
+    }
+
+    size_t count() const { return samples.size(); }
+    double seconds() const { return total / 1e9; }
+
+    void report(const char* name) {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+        std::printf("%-13s %9zu %12.0f", name, samples.size(), samples.size() / seconds());
+        for (double p : percentiles) {
+            size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+            std::printf(" %11.2f", samples[rank > 0 ? rank - 1 : 0] / 1e3);
+        }
+        std::printf(" %11.2f\n", samples.back() / 1e3);
+    }
+};
+
+// Time body(sample) until the sample or time budget runs out
+template <typename Body>
+static Latencies measure(const Options& options, Body body) {
+    typedef std::chrono::steady_clock Clock;
+    Latencies latencies;
+    latencies.reserve(options.samples);
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                                    std::chrono::duration<double>(options.seconds));
+    for (size_t sample = 0; sample < options.samples; ++sample) {
+        Clock::duration elapsed = body(sample);
+        latencies.add(elapsed);
+        if (Clock::now() >= deadline) break;
+    }
+    return latencies;
+}
+
+static void run(const Options& options, size_t size) {
+    typedef std::chrono::steady_clock Clock;
+    Generator random(options);
+    Inventory inventory;
+    NullSink sink;
+    inventory.setOutput(sink);
+    char id[32];
+    char name[32];
+
+    Latencies adds;
+    adds.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        formatId(id, sizeof id, i);
+        formatName(name, sizeof name, i);
+        int quantity = random.quantity();
+        double price = random.price();
+        int category = random.category();
+        Clock::time_point started = Clock::now();
+        inventory.addItem(id, name, quantity, price, category);
+        adds.add(Clock::now() - started);
+    }
+
+    std::printf("\n%zu items, %zu low stock\n%-13s %9s %12s %11s %11s %11s %11s %11s\n", size,
+                inventory.getLowStockMembers().size(), "operation", "samples", "ops/sec", "p50 us", "p90 us",
+                "p99 us", "p99.9 us", "max us");
+    adds.report("add");
+
+    measure(options, [&](size_t) {
+        formatId(id, sizeof id, random.below(size));
+        Clock::time_point started = Clock::now();
+        inventory.searchItem(id);
+        return Clock::now() - started;
+    }).report("search");
+
+    measure(options, [&](size_t) {
+        formatId(id, sizeof id, random.below(size));
+        int quantity = random.quantity();
+        Clock::time_point started = Clock::now();
+        inventory.setQuantity(id, quantity);
+        return Clock::now() - started;
+    }).report("set quantity");
+
+    measure(options, [&](size_t) {
+        size_t number = random.below(size);
+        formatId(id, sizeof id, number);
+        const Item* item = inventory.getItem(id);
+        Item removed = *item;
+        Clock::time_point started = Clock::now();
+        inventory.removeItem(id);
+        Clock::duration elapsed = Clock::now() - started;
+        inventory.insertItem(std::move(removed));
+        return elapsed;
+    }).report("remove");
+
+    measure(options, [&](size_t sample) {
+        Clock::time_point started = Clock::now();
+        inventory.displayItemsByCategory(static_cast<int>(1 + sample % 3));
+        return Clock::now() - started;
+    }).report("category");
+
+    measure(options, [&](size_t sample) {
+        Clock::time_point started = Clock::now();
+        inventory.sortItems(sample % 2 == 0, sample % 4 < 2);
+        return Clock::now() - started;
+    }).report("sort");
+
+    const std::vector<SortKey> keys = {SortKey{SortField::Category, true}, SortKey{SortField::Price, false}};
+    measure(options, [&](size_t) {
+        Clock::time_point started = Clock::now();
+        inventory.sortItems(keys);
+        return Clock::now() - started;
+    }).report("sort keys");
+
+    measure(options, [&](size_t) {
+        Clock::time_point started = Clock::now();
+        inventory.displayTopItems(true, false, 10);
+        return Clock::now() - started;
+    }).report("top 10");
+
+    measure(options, [&](size_t) {
+        Clock::time_point started = Clock::now();
+        inventory.displayLowStockItems();
+        return Clock::now() - started;
+    }).report("low stock");
+}
+
+// Comma-separated numbers; false if any is malformed
+static bool parseList(const char* text, std::vector<double>& values) {
+    values.clear();
+    while (*text != '\0') {
+        char* end;
+        double value = std::strtod(text, &end);
+        if (end == text || !(value >= 0)) return false;
+        values.push_back(value);
+        text = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return false;
+    }
+    return !values.empty();
+}
+
+static bool parseQuantity(const char* text, Options& options) {
+    const char* colon = std::strchr(text, ':');
+    if (colon == nullptr) return false;
+    size_t kind = static_cast<size_t>(colon - text);
+    if (kind == 7 && std::strncmp(text, "uniform", kind) == 0) options.exponential = false;
+    else if (kind == 11 && std::strncmp(text, "exponential", kind) == 0) options.exponential = true;
+    else return false;
+    char* end;
+    options.quantityScale = std::strtod(colon + 1, &end);
+    return end != colon + 1 && *end == '\0' && options.quantityScale >= 0;
+}
+
+static int usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--sizes N,N,...] [--categories W1,W2,W3]\n"
+                 "       [--quantity uniform:MAX|exponential:MEAN]\n"
+                 "       [--samples S] [--seconds T] [--seed X]\n",
+                 program);
+    return 1;
+}
+
+// A non-negative whole number with nothing after it
+static bool parseCount(const char* text, unsigned long long& value) {
+    char* end;
+    value = std::strtoull(text, &end, 10);
+    return end != text && *end == '\0' && text[0] != '-';
+}
+
+// A non-negative number of seconds
+static bool parseSeconds(const char* text, double& value) {
+    char* end;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<double> values;
+    unsigned long long count;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 == argc) {
+            std::fprintf(stderr, "missing value for %s\n", argv[i]);
+            return usage(argv[0]);
+        }
+        const char* value = argv[i + 1];
+        bool ok = true;
+        if (std::strcmp(argv[i], "--sizes") == 0) {
+            ok = parseList(value, values);
+            options.sizes.assign(values.begin(), values.end());
+        } else if (std::strcmp(argv[i], "--categories") == 0) {
+            ok = parseList(value, values) && values.size() == 3 && values[0] + values[1] + values[2] > 0;
+            if (ok) std::copy(values.begin(), values.end(), options.categoryWeights);
+        } else if (std::strcmp(argv[i], "--quantity") == 0) {
+            ok = parseQuantity(value, options);
+        } else if (std::strcmp(argv[i], "--samples") == 0) {
+            ok = parseCount(value, count);
+            options.samples = static_cast<size_t>(count);
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            ok = parseSeconds(value, options.seconds);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            ok = parseCount(value, count);
+            options.seed = count | 1;
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return usage(argv[0]);
+        }
+        if (!ok) {
+            std::fprintf(stderr, "bad value for %s: %s\n", argv[i], value);
+            return usage(argv[0]);
+        }
+    }
+    if (options.samples == 0) options.samples = 1;
+
+    std::printf("categories %g:%g:%g, quantity %s %g, up to %zu samples or %gs per operation\n",
+                options.categoryWeights[0], options.categoryWeights[1], options.categoryWeights[2],
+                options.exponential ? "exponential, mean" : "uniform, 0 to", options.quantityScale, options.samples,
+                options.seconds);
+
+    NullBuffer discard;
+    std::streambuf* console = std::cout.rdbuf(&discard);
+    for (size_t size : options.sizes) {
+        if (size > 0) run(options, size);
+    }
+    std::cout.rdbuf(console);
+    return 0;
+}
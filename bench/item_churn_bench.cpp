@@ -0,0 +1,106 @@
+// Memory under add/remove churn.
+//
+// Fills an Inventory, then repeatedly removes randomly chosen items and
+// adds as many new ones, the way SKUs are retired and introduced. Each run
+// removes a different number of items per round. After each run it shows
+// the ItemStore statistics and how many StringArena chunks are live. With
+// text blocks reused from the store's pool, the chunk count stays near its
+// value after the fill. Without reuse, every new item's text would land in
+// a fresh chunk, and old chunks would stay pinned by their few surviving
+// items.
+//
+// usage: item_churn_bench [--items N] [--operations M]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "inventory.h"
+
+static uint64_t nextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+class Churn {
+private:
+    Inventory inventory;
+    std::vector<std::string> ids;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    size_t nextId = 0;
+
+public:
+    void add() {
+        char id[32];
+        char name[48];
+        std::snprintf(id, sizeof id, "SKU%zu", nextId++);
+        size_t nameLength = 5 + nextRandom(state) % 30;
+        for (size_t i = 0; i < nameLength; ++i) name[i] = static_cast<char>('a' + nextRandom(state) % 26);
+        inventory.insertItem(Item(id, TextView(name, nameLength), static_cast<int>(nextRandom(state) % 100),
+                                  1 + nextRandom(state) % 10000 / 100.0, static_cast<Category>(1 + nextRandom(state) % 3)));
+        ids.push_back(id);
+    }
+
+    void removeRandom() {
+        size_t k = nextRandom(state) % ids.size();
+        inventory.eraseItem(ids[k]);
+        ids[k].swap(ids.back());
+        ids.pop_back();
+    }
+
+    Inventory& get() { return inventory; }
+};
+
+static void report(const char* label, const Inventory& inventory, double opsPerSecond) {
+    ItemStoreStats store = inventory.storeStats();
+    StringArenaStats arena = StringArena::stats();
+    std::printf("%-16s %9zu %7zu %10.1f %10.1f %8zu %10llu %12.0f\n", label, store.items, arena.chunks,
+                arena.bytes / 1048576.0, inventory.memoryUsage() / 1048576.0, store.pooledBlocks,
+                static_cast<unsigned long long>(store.reusedBlocks), opsPerSecond);
+}
+
+int main(int argc, char* argv[]) {
+    size_t items = 1000000;
+    size_t operations = 5000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--items") == 0) items = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--operations") == 0) operations = std::strtoull(argv[i + 1], nullptr, 10);
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (items == 0) items = 1;
+
+    std::printf("%zu items, %zu removes and adds per run\n\n%-16s %9s %7s %10s %10s %8s %10s %12s\n", items,
+                operations, "run", "items", "chunks", "arena MiB", "store MiB", "pooled", "reused", "ops/sec");
+    const size_t batches[] = {1, 1000, items / 8};
+    for (size_t batch : batches) {
+        if (batch == 0) continue;
+        Churn churn;
+        churn.get().reserve(items);
+        for (size_t i = 0; i < items; ++i) churn.add();
+        report("filled", churn.get(), 0);
+
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        for (size_t done = 0; done < operations; done += batch) {
+            for (size_t i = 0; i < batch; ++i) churn.removeRandom();
+            for (size_t i = 0; i < batch; ++i) churn.add();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        char label[32];
+        std::snprintf(label, sizeof label, "churn by %zu", batch);
+        report(label, churn.get(), operations / seconds);
+
+        churn.get().clear();
+        report("cleared", churn.get(), 0);
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Heap allocations and time per item lookup.
+//
+// Replaces the global operator new to count every allocation, fills an
+// Inventory with items whose IDs are too long for the small-string buffer,
+// then counts the allocations made while it
+//
+//   - looks items up by a TextView of a caller's buffer (hits and misses,
+//     in mixed case),
+//   - reads every item's ID and name,
+//   - runs search commands through a BatchRunner,
+//   - sets and adjusts quantities and prices by ID,
+//
+// and, for comparison, looks the items up through a std::string built for
+// each call, the way the lookups took their keys before. The lookups, the
+// reads and the batch searches must make no allocations; the program fails
+// if one does. Updates are shown for reference: finding the item allocates
+// nothing, but the sorted indexes allocate when one of their chunks splits.
+//
+// usage: lookup_alloc_bench [--items N]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "batch_runner.h"
+#include "inventory.h"
+
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+// Not inlined, so GCC does not take a free() of memory from operator new
+// for a mismatched pair
+#ifdef __GNUC__
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+void* operator new[](size_t size) { return operator new(size); }
+BENCH_NOINLINE void operator delete(void* memory) noexcept { std::free(memory); }
+BENCH_NOINLINE void operator delete[](void* memory) noexcept { std::free(memory); }
+BENCH_NOINLINE void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+BENCH_NOINLINE void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+// Keeps the results of the timed loops from being optimized away
+static volatile uint64_t observed;
+
+class NullSink : public OutputSink {
+public:
+    void write(const char*, size_t) override {}
+};
+
+struct Section {
+    uint64_t operations = 0;
+    uint64_t allocations = 0;
+    double seconds = 0;
+};
+
+// Run body, counting the allocations it makes; body returns its operations
+template <typename Body>
+static Section measure(Body body) {
+    Section section;
+    uint64_t before = allocations.load();
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    section.operations = body();
+    section.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    section.allocations = allocations.load() - before;
+    return section;
+}
+
+static void report(const char* name, const Section& section) {
+    std::printf("%-30s %10llu %12llu %10.3f %9.1f\n", name, static_cast<unsigned long long>(section.operations),
+                static_cast<unsigned long long>(section.allocations),
+                static_cast<double>(section.allocations) / section.operations,
+                section.seconds * 1e9 / section.operations);
+}
+
+// ID of item i: 19 characters, past any small-string buffer
+static const size_t idLength = 19;
+
+static void formatId(char* id, size_t size, size_t i, bool upper) {
+    std::snprintf(id, size, "%s%016llu", upper ? "SKU" : "sku", static_cast<unsigned long long>(i % 10000000000000000ull));
+}
+
+int main(int argc, char* argv[]) {
+    size_t itemCount = 200000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--items") == 0) itemCount = std::strtoull(argv[i + 1], nullptr, 10);
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (itemCount == 0) itemCount = 1;
+
+    Inventory inventory;
+    inventory.reserve(itemCount);
+    char id[32];
+    char name[48];
+    for (size_t i = 0; i < itemCount; ++i) {
+        formatId(id, sizeof id, i, true);
+        std::snprintf(name, sizeof name, "Item number %zu", i);
+        inventory.insertItem(Item(id, name, static_cast<int>(i % 1000), 1 + i % 500, static_cast<Category>(1 + i % 3)));
+    }
+
+    std::printf("%zu items\n\n%-30s %10s %12s %10s %9s\n", itemCount, "section", "operations", "allocations",
+                "per op", "ns/op");
+
+    Section lookups = measure([&] {
+        uint64_t found = 0;
+        for (size_t i = 0; i < 2 * itemCount; ++i) {
+            formatId(id, sizeof id, i, i % 2 == 0);
+            if (inventory.getItem(TextView(id, idLength)) != nullptr) ++found;
+        }
+        observed = found;
+        return 2 * static_cast<uint64_t>(itemCount);
+    });
+    report("getItem(TextView)", lookups);
+
+    Section reads = measure([&] {
+        uint64_t bytes = 0;
+        for (const Item& item : inventory.getItems()) {
+            TextView itemId = item.getId();
+            TextView itemName = item.getName();
+            bytes += itemId.length() + itemName.length() + static_cast<unsigned char>(itemId[0]);
+        }
+        observed = bytes;
+        return static_cast<uint64_t>(inventory.getItems().size());
+    });
+    report("getId + getName", reads);
+
+    // Write the batch commands before counting; the runner's buffers are
+    // allocated when it is constructed
+    FILE* commands = std::tmpfile();
+    if (commands == nullptr) {
+        std::perror("tmpfile");
+        return 1;
+    }
+    for (size_t i = 0; i < itemCount; ++i) {
+        formatId(id, sizeof id, i, i % 2 == 0);
+        std::fprintf(commands, "search %s\n", id);
+    }
+    std::fflush(commands);
+    std::rewind(commands);
+    NullSink sink;
+    BatchRunner runner(inventory, sink);
+    BatchReport batchReport;
+    Section batch = measure([&] {
+        runner.run(fileno(commands), batchReport);
+        return batchReport.commands;
+    });
+    std::fclose(commands);
+    if (batchReport.errors != 0) {
+        std::printf("%llu batch commands failed\n", static_cast<unsigned long long>(batchReport.errors));
+    }
+    report("batch search", batch);
+
+    Section updates = measure([&] {
+        uint64_t failed = 0;
+        for (size_t i = 0; i < itemCount; ++i) {
+            formatId(id, sizeof id, i, i % 2 == 1);
+            TextView key(id, idLength);
+            if (inventory.setQuantity(key, 500) != UpdateStatus::Ok) ++failed;
+            if (inventory.adjustQuantity(key, -1) != UpdateStatus::Ok) ++failed;
+            if (inventory.setPrice(key, 10 + i % 90) != UpdateStatus::Ok) ++failed;
+        }
+        if (failed != 0) std::printf("%llu updates failed\n", static_cast<unsigned long long>(failed));
+        return 3 * static_cast<uint64_t>(itemCount);
+    });
+    report("set/adjust quantity, price", updates);
+
+    Section baseline = measure([&] {
+        uint64_t found = 0;
+        for (size_t i = 0; i < 2 * itemCount; ++i) {
+            formatId(id, sizeof id, i, i % 2 == 0);
+            if (inventory.getItem(std::string(id, idLength)) != nullptr) ++found;
+        }
+        observed = found;
+        return 2 * static_cast<uint64_t>(itemCount);
+    });
+    report("getItem(std::string) baseline", baseline);
+
+    bool allocationFree = lookups.allocations == 0 && reads.allocations == 0 && batch.allocations == 0;
+    std::printf("\n%s\n", allocationFree ? "lookups made no heap allocations"
+                                          : "FAILED: lookups made heap allocations");
+    return allocationFree ? 0 : 1;
+}
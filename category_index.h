@@ -0,0 +1,52 @@
+#ifndef CATEGORY_INDEX_H
+#define CATEGORY_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "item.h"
+#include "item_store.h"
+
+// Membership lists of items per category.
+//
+// Each category keeps a dense vector of handles. Removal moves the bucket's
+// last handle into the freed position, so both insert and erase are O(1); the
+// position of every handle in its bucket is tracked by item slot.
+class CategoryIndex {
+private:
+    std::vector<ItemHandle> buckets[categoryCount];
+    std::vector<uint32_t> positions; // item slot -> position in its bucket
+
+    std::vector<ItemHandle>& bucket(Category category) {
+        return buckets[static_cast<int>(category) - 1];
+    }
+
+public:
+    void insert(Category category, ItemHandle handle) {
+        std::vector<ItemHandle>& members = bucket(category);
+        if (handle.slot >= positions.size()) {
+            positions.resize(handle.slot + 1);
+        }
+        positions[handle.slot] = static_cast<uint32_t>(members.size());
+        members.push_back(handle);
+    }
+
+    void erase(Category category, ItemHandle handle) {
+        std::vector<ItemHandle>& members = bucket(category);
+        uint32_t position = positions[handle.slot];
+        members[position] = members.back();
+        positions[members[position].slot] = position;
+        members.pop_back();
+    }
+
+    void clear() {
+        for (std::vector<ItemHandle>& members : buckets) members.clear();
+        positions.clear();
+    }
+
+    const std::vector<ItemHandle>& members(Category category) const {
+        return buckets[static_cast<int>(category) - 1];
+    }
+};
+
+#endif
@@ -0,0 +1,577 @@
+#ifndef CONCURRENT_INVENTORY_H
+#define CONCURRENT_INVENTORY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "inventory.h"
+#include "item.h"
+#include "item_sorter.h"
+#include "quantity_counter.h"
+#include "sorted_index.h"
+
+// Inventory that many threads may use at once.
+//
+// Items are spread over shards by ID hash; each shard is an ordinary
+// Inventory behind its own reader/writer lock, so lookups in different
+// shards never contend and lookups in the same shard only share the lock.
+// Writes lock one shard exclusively. Shards are allocated separately, so
+// their locks do not share cache lines.
+//
+// Lookups, updates and per-category/low-stock listings lock one shard at a
+// time. Sorted listings hold every shard's read lock (taken in shard order)
+// while they merge the shards' indexes, so they see a consistent state.
+// Listings that are not sorted come out grouped by shard.
+//
+// Items marked hot keep their quantity in a QuantityCounter. Each shard
+// publishes its counters in a hash table that is only ever added to, so
+// adjusting a hot item's quantity finds the counter without taking the
+// shard's lock or allocating, and applies the change with a CAS. While an
+// item is hot the counter is authoritative; the shard's copy of the
+// quantity (and its quantity and low-stock indexes) catch up whenever the
+// shard is write-locked for a listing, a batch or unmarkHot. Work under
+// the write lock closes the counters it depends on first, which sends
+// concurrent adjustments to wait for the lock.
+class ConcurrentInventory: public InventoryBase {
+private:
+    // An item that has been marked hot, under its normalized ID. Kept for
+    // the life of the shard, since a lock-free reader may still hold it.
+    struct HotItem {
+        std::string id;
+        QuantityCounter counter;
+        // marked and not since unmarked; changed under the write lock
+        bool hot = true;
+
+        HotItem(std::string id, int quantity) : id(std::move(id)), counter(quantity) {}
+
+        // Whether id, in any case, is this item's
+        bool hasId(TextView other) const {
+            if (other.length() != id.length()) return false;
+            for (size_t i = 0; i < id.length(); ++i) {
+                if (foldIdChar(other[i]) != id[i]) return false;
+            }
+            return true;
+        }
+    };
+
+    // Open-addressing table of HotItems by ID hash, at most half full.
+    // Slots are only filled, under the write lock, so readers probe it
+    // without a lock; a full table is replaced by one twice the size.
+    struct HotTable {
+        size_t mask;
+        size_t used = 0;
+        std::unique_ptr<std::atomic<HotItem*>[]> slots;
+
+        explicit HotTable(size_t size) : mask(size - 1), slots(new std::atomic<HotItem*>[size]) {
+            for (size_t i = 0; i < size; ++i) slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        HotItem* find(TextView id) const {
+            for (size_t i = hashItemId(id.data(), id.length()) & mask;; i = (i + 1) & mask) {
+                HotItem* item = slots[i].load(std::memory_order_acquire);
+                if (item == nullptr || item->hasId(id)) return item;
+            }
+        }
+
+        bool full() const { return (used + 1) * 2 > mask + 1; }
+
+        void add(HotItem* item) {
+            size_t i = hashItemId(item->id.data(), item->id.length()) & mask;
+            while (slots[i].load(std::memory_order_relaxed) != nullptr) i = (i + 1) & mask;
+            slots[i].store(item, std::memory_order_release);
+            ++used;
+        }
+    };
+
+    struct Shard {
+        mutable std::shared_timed_mutex lock;
+        Inventory items;
+        // Current table of hot items, readable without the lock
+        std::atomic<HotTable*> hotTable{nullptr};
+        // The current table and the ones it replaced, which a lock-free
+        // reader may still be probing; changed under the write lock
+        std::vector<std::unique_ptr<HotTable>> hotTables;
+        // Every item ever marked hot; changed under the write lock
+        std::vector<std::unique_ptr<HotItem>> hotItems;
+        // Items marked hot now, readable without the lock
+        std::atomic<size_t> hotCount{0};
+    };
+
+    typedef std::shared_lock<std::shared_timed_mutex> ReadLock;
+    typedef std::unique_lock<std::shared_timed_mutex> WriteLock;
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<int> count{0};
+    // serializes whole tables written to the shared output
+    std::mutex outputLock;
+
+    // The high bits of the hash pick the shard; the low bits are left to
+    // the shard's own hash index
+    size_t shardIndex(TextView id) const {
+        uint64_t hash = hashItemId(id.data(), id.length());
+        return static_cast<size_t>((hash * shards.size()) >> 32);
+    }
+
+    Shard& shardFor(TextView id) const { return *shards[shardIndex(id)]; }
+
+    std::vector<ReadLock> lockAll() const {
+        std::vector<ReadLock> locks;
+        locks.reserve(shards.size());
+        for (const std::unique_ptr<Shard>& shard : shards) locks.emplace_back(shard->lock);
+        return locks;
+    }
+
+    // The item ever marked hot under id, or nullptr; needs no lock
+    static HotItem* findHot(const Shard& shard, TextView id) {
+        const HotTable* table = shard.hotTable.load(std::memory_order_acquire);
+        return table == nullptr ? nullptr : table->find(id);
+    }
+
+    // Counter of a hot item whose counter is open, or nullptr. Without the
+    // lock the counter may be closed by the time it is used; adjust() then
+    // reports NotFound.
+    static QuantityCounter* hotCounter(const Shard& shard, TextView id) {
+        HotItem* item = findHot(shard, id);
+        return item != nullptr && item->counter.isOpen() ? &item->counter : nullptr;
+    }
+
+    // Needs the write lock
+    static void addHot(Shard& shard, HotItem* item) {
+        HotTable* table = shard.hotTable.load(std::memory_order_relaxed);
+        if (table == nullptr || table->full()) {
+            HotTable* grown = new HotTable(table == nullptr ? 8 : (table->mask + 1) * 2);
+            shard.hotTables.emplace_back(grown);
+            for (const std::unique_ptr<HotItem>& hot : shard.hotItems) grown->add(hot.get());
+            shard.hotTable.store(grown, std::memory_order_release);
+        } else {
+            table->add(item);
+        }
+    }
+
+    // Close the hot counters and copy their quantities into the shard's
+    // items; needs the write lock
+    static void closeHot(Shard& shard) {
+        for (const std::unique_ptr<HotItem>& hot : shard.hotItems) {
+            if (!hot->hot) continue;
+            int quantity = hot->counter.close();
+            const Item* item = shard.items.getItem(hot->id);
+            if (item != nullptr && item->getQuantity() != quantity) shard.items.setQuantity(hot->id, quantity);
+        }
+    }
+
+    // Reopen the hot counters at the items' quantities; needs the write lock
+    static void openHot(Shard& shard) {
+        for (const std::unique_ptr<HotItem>& hot : shard.hotItems) {
+            if (!hot->hot) continue;
+            const Item* item = shard.items.getItem(hot->id);
+            hot->counter.open(item != nullptr ? item->getQuantity() : 0);
+        }
+    }
+
+    // Bring the shard's items up to date with its hot counters; needs the
+    // write lock
+    static void foldHot(Shard& shard) {
+        closeHot(shard);
+        openHot(shard);
+    }
+
+    // Needs the write lock
+    bool unmarkHot(Shard& shard, TextView id) {
+        HotItem* hot = findHot(shard, id);
+        if (hot == nullptr || !hot->hot) return false;
+        int quantity = hot->counter.close();
+        if (shard.items.getItem(id) != nullptr) shard.items.setQuantity(id, quantity);
+        hot->hot = false;
+        shard.hotCount.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Bring every shard's items up to date with its hot counters
+    void foldAllHot() {
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            if (shard->hotCount.load(std::memory_order_relaxed) == 0) continue;
+            WriteLock guard(shard->lock);
+            foldHot(*shard);
+        }
+    }
+
+    template <typename Iterator>
+    struct Cursor {
+        Iterator position;
+        Iterator end;
+        size_t shard;
+    };
+
+    // Merge the shards' sorted indexes, displaying up to limit items
+    template <typename T>
+    void displayMerged(const SortedIndex<T>& (Inventory::*index)() const, bool ascending, size_t limit) {
+        std::vector<ReadLock> locks = lockAll();
+        writeSortedHeader();
+        if (ascending) {
+            std::vector<Cursor<typename SortedIndex<T>::const_iterator>> cursors;
+            for (size_t s = 0; s < shards.size(); ++s) {
+                const SortedIndex<T>& sorted = (shards[s]->items.*index)();
+                if (sorted.size() > 0) cursors.push_back({sorted.begin(), sorted.end(), s});
+            }
+            displayMerged(cursors, true, limit);
+        } else {
+            std::vector<Cursor<typename SortedIndex<T>::const_reverse_iterator>> cursors;
+            for (size_t s = 0; s < shards.size(); ++s) {
+                const SortedIndex<T>& sorted = (shards[s]->items.*index)();
+                if (sorted.size() > 0) cursors.push_back({sorted.rbegin(), sorted.rend(), s});
+            }
+            displayMerged(cursors, false, limit);
+        }
+        table.flush();
+    }
+
+    // Cursors form a heap whose top is the next item in order
+    template <typename Iterator>
+    void displayMerged(std::vector<Cursor<Iterator>>& cursors, bool ascending, size_t limit) {
+        auto later = [ascending](const Cursor<Iterator>& a, const Cursor<Iterator>& b) {
+            if (a.position->value != b.position->value) {
+                return ascending ? b.position->value < a.position->value : a.position->value < b.position->value;
+            }
+            return a.shard > b.shard;
+        };
+        std::make_heap(cursors.begin(), cursors.end(), later);
+        for (size_t shown = 0; shown < limit && !cursors.empty(); ++shown) {
+            std::pop_heap(cursors.begin(), cursors.end(), later);
+            Cursor<Iterator>& next = cursors.back();
+            shards[next.shard]->items.getItems().get(next.position->handle)->displayItem(table);
+            if (++next.position == next.end) {
+                cursors.pop_back();
+            } else {
+                std::push_heap(cursors.begin(), cursors.end(), later);
+            }
+        }
+    }
+
+    static double sortValue(const Item& item, SortField field) {
+        switch (field) {
+            case SortField::Quantity: return item.getQuantity();
+            case SortField::Price: return item.getPrice();
+            case SortField::Category: return static_cast<int>(item.getCategory());
+        }
+        return 0;
+    }
+
+public:
+    // shardCount is rounded up to at least 1
+    explicit ConcurrentInventory(size_t shardCount = 64) {
+        shardCount = std::max<size_t>(shardCount, 1);
+        for (size_t i = 0; i < shardCount; ++i) shards.emplace_back(new Shard());
+    }
+
+    int getItemCount() const override { return count.load(std::memory_order_relaxed); }
+
+    size_t shardCount() const { return shards.size(); }
+
+    // Quiet add; false if the ID is taken
+    bool insertItem(Item item) {
+        TIME_OPERATION(Operation::Add);
+        Shard& shard = shardFor(item.getId());
+        WriteLock guard(shard.lock);
+        if (!shard.items.insertItem(std::move(item))) return false;
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool eraseItem(TextView id) {
+        TIME_OPERATION(Operation::Remove);
+        Shard& shard = shardFor(id);
+        WriteLock guard(shard.lock);
+        if (!shard.items.eraseItem(id)) return false;
+        unmarkHot(shard, id);
+        count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Copy of the item with the given ID; false if there is none
+    bool getItem(TextView id, Item& copy) const {
+        const Shard& shard = shardFor(id);
+        ReadLock guard(shard.lock);
+        const Item* item = shard.items.getItem(id);
+        if (item == nullptr) return false;
+        if (QuantityCounter* counter = hotCounter(shard, id)) {
+            copy = Item(item->getId(), item->getName(), counter->load(), item->getPrice(), item->getCategory());
+        } else {
+            copy = *item;
+        }
+        return true;
+    }
+
+    // Move an item's quantity into a lock-free counter; false if not found
+    bool markHot(TextView id) {
+        Shard& shard = shardFor(id);
+        WriteLock guard(shard.lock);
+        const Item* item = shard.items.getItem(id);
+        if (item == nullptr) return false;
+        HotItem* hot = findHot(shard, id);
+        if (hot != nullptr && hot->hot) return true;
+        if (hot != nullptr) {
+            hot->counter.open(item->getQuantity());
+            hot->hot = true;
+        } else {
+            shard.hotItems.emplace_back(new HotItem(normalizeItemId(id), item->getQuantity()));
+            addHot(shard, shard.hotItems.back().get());
+        }
+        shard.hotCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Return a hot item's quantity to the shard; false if it was not hot
+    bool unmarkHot(TextView id) {
+        Shard& shard = shardFor(id);
+        WriteLock guard(shard.lock);
+        return unmarkHot(shard, id);
+    }
+
+    bool isHot(TextView id) const {
+        const Shard& shard = shardFor(id);
+        ReadLock guard(shard.lock);
+        HotItem* hot = findHot(shard, id);
+        return hot != nullptr && hot->hot;
+    }
+
+    void addItem(TextView id, TextView name, int quantity, double price, int category) override {
+        if (!isValidCategory(category)) {
+            std::cout << "Category does not exist!" << std::endl;
+            return;
+        }
+        if (!insertItem(Item(id, name, quantity, price, static_cast<Category>(category)))) {
+            std::cout << "Item ID already exists!" << std::endl;
+            return;
+        }
+        std::cout << "Item added successfully!" << std::endl;
+    }
+
+    // The prompts run without holding a lock; the change is applied after
+    void updateItem(TextView id) override {
+        Item item("", "", 0, 0, Category::Clothing);
+        if (!getItem(id, item)) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        int newQuantity;
+        double newPrice;
+        UpdateStatus status;
+        if (promptUpdate(newQuantity, newPrice) == UpdateKind::SetQuantity) {
+            reportQuantityUpdate(item, newQuantity);
+            status = setQuantity(id, newQuantity);
+        } else {
+            reportPriceUpdate(item, newPrice);
+            status = setPrice(id, newPrice);
+        }
+        if (status != UpdateStatus::Ok) std::cout << "Update failed: " << updateStatusMessage(status) << std::endl;
+    }
+
+    void removeItem(TextView id) override {
+        TIME_OPERATION(Operation::Remove);
+        std::string name;
+        bool found;
+        {
+            Shard& shard = shardFor(id);
+            WriteLock guard(shard.lock);
+            const Item* item = shard.items.getItem(id);
+            found = item != nullptr;
+            if (found) {
+                name = item->getName().str();
+                shard.items.eraseItem(id);
+                unmarkHot(shard, id);
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        if (!found) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        std::cout << "Item " << name << " has been removed from the inventory." << std::endl;
+    }
+
+    UpdateStatus setQuantity(TextView id, int quantity) override {
+        TIME_OPERATION(Operation::Update);
+        Shard& shard = shardFor(id);
+        WriteLock guard(shard.lock);
+        UpdateStatus status = shard.items.setQuantity(id, quantity);
+        QuantityCounter* counter = hotCounter(shard, id);
+        if (status == UpdateStatus::Ok && counter != nullptr) counter->store(quantity);
+        return status;
+    }
+
+    UpdateStatus adjustQuantity(TextView id, int delta) override {
+        TIME_OPERATION(Operation::Update);
+        Shard& shard = shardFor(id);
+        int result;
+        if (shard.hotCount.load(std::memory_order_relaxed) > 0) {
+            if (QuantityCounter* counter = hotCounter(shard, id)) {
+                UpdateStatus status = counter->adjust(delta, result);
+                if (status != UpdateStatus::NotFound) return status;
+            }
+        }
+        // Not hot, or marked hot or closed since the check above
+        WriteLock guard(shard.lock);
+        if (QuantityCounter* counter = hotCounter(shard, id)) return counter->adjust(delta, result);
+        return shard.items.adjustQuantity(id, delta);
+    }
+
+    UpdateStatus setPrice(TextView id, double price) override {
+        TIME_OPERATION(Operation::Update);
+        Shard& shard = shardFor(id);
+        WriteLock guard(shard.lock);
+        return shard.items.setPrice(id, price);
+    }
+
+    // Updates are grouped by shard and each shard is locked once; updates
+    // to the same item keep their order
+    size_t applyUpdates(const ItemUpdate* updates, size_t updateCount, UpdateStatus* statuses) override {
+        std::vector<std::vector<size_t>> byShard(shards.size());
+        for (size_t i = 0; i < updateCount; ++i) byShard[shardIndex(updates[i].id)].push_back(i);
+
+        size_t applied = 0;
+        std::vector<ItemUpdate> batch;
+        std::vector<UpdateStatus> results;
+        for (size_t s = 0; s < shards.size(); ++s) {
+            if (byShard[s].empty()) continue;
+            batch.clear();
+            for (size_t i : byShard[s]) batch.push_back(updates[i]);
+            results.resize(batch.size());
+            {
+                Shard& shard = *shards[s];
+                WriteLock guard(shard.lock);
+                closeHot(shard);
+                applied += shard.items.applyUpdates(batch.data(), batch.size(), results.data());
+                openHot(shard);
+            }
+            if (statuses != nullptr) {
+                for (size_t k = 0; k < batch.size(); ++k) statuses[byShard[s][k]] = results[k];
+            }
+        }
+        return applied;
+    }
+
+    void displayItemsByCategory(int category) override {
+        TIME_OPERATION(Operation::ListCategory);
+        if (!isValidCategory(category)) {
+            std::cout << "Category does not exist!" << std::endl;
+            return;
+        }
+        foldAllHot();
+        std::lock_guard<std::mutex> output(outputLock);
+        writeCategoryHeader();
+        bool any = false;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            ReadLock guard(shard->lock);
+            const ItemStore& items = shard->items.getItems();
+            for (ItemHandle handle : shard->items.getCategoryMembers(static_cast<Category>(category))) {
+                items.get(handle)->displayItem(table);
+                any = true;
+            }
+        }
+        if (!any) table.line("No items found in this category.");
+        table.flush();
+    }
+
+    void displayAllItems() override {
+        TIME_OPERATION(Operation::ListAll);
+        foldAllHot();
+        std::lock_guard<std::mutex> output(outputLock);
+        if (isEmpty()) {
+            std::cout << "No items in the inventory." << std::endl;
+            return;
+        }
+        writeFullHeader();
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            ReadLock guard(shard->lock);
+            for (const Item& item : shard->items.getItems()) item.displayItem(table);
+        }
+        table.flush();
+    }
+
+    void searchItem(TextView id) override {
+        TIME_OPERATION(Operation::Search);
+        Item item("", "", 0, 0, Category::Clothing);
+        bool found = getItem(id, item);
+        std::lock_guard<std::mutex> output(outputLock);
+        if (!found) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        writeFullHeader();
+        item.displayItem(table);
+        table.flush();
+    }
+
+    void sortItems(bool byQuantity, bool ascending) override {
+        displayTopItems(byQuantity, ascending, getItemCount());
+    }
+
+    // Sorted with a comparison sort over every shard's items
+    void sortItems(const std::vector<SortKey>& keys) override {
+        TIME_OPERATION(Operation::Sort);
+        foldAllHot();
+        std::lock_guard<std::mutex> output(outputLock);
+        std::vector<ReadLock> locks = lockAll();
+        std::vector<const Item*> sorted;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            for (const Item& item : shard->items.getItems()) sorted.push_back(&item);
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [&](const Item* a, const Item* b) {
+            for (const SortKey& key : keys) {
+                double x = sortValue(*a, key.field);
+                double y = sortValue(*b, key.field);
+                if (x != y) return key.ascending ? x < y : x > y;
+            }
+            return false;
+        });
+        writeSortedHeader();
+        for (const Item* item : sorted) item->displayItem(table);
+        table.flush();
+    }
+
+    void displayTopItems(bool byQuantity, bool ascending, int limit) override {
+        TIME_OPERATION(Operation::Sort);
+        foldAllHot();
+        std::lock_guard<std::mutex> output(outputLock);
+        size_t shown = limit > 0 ? static_cast<size_t>(limit) : 0;
+        if (byQuantity) {
+            displayMerged<int>(&Inventory::getQuantityIndex, ascending, shown);
+        } else {
+            displayMerged<double>(&Inventory::getPriceIndex, ascending, shown);
+        }
+    }
+
+    void setLowStockThreshold(Category category, int threshold) {
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            WriteLock guard(shard->lock);
+            shard->items.setLowStockThreshold(category, threshold);
+        }
+    }
+
+    void displayLowStockItems() override {
+        TIME_OPERATION(Operation::LowStock);
+        foldAllHot();
+        std::lock_guard<std::mutex> output(outputLock);
+        writeFullHeader();
+        bool any = false;
+        for (const std::unique_ptr<Shard>& shard : shards) {
+            ReadLock guard(shard->lock);
+            const ItemStore& items = shard->items.getItems();
+            for (ItemHandle handle : shard->items.getLowStockMembers()) {
+                items.get(handle)->displayItem(table);
+                any = true;
+            }
+        }
+        if (!any) table.line("No low stock items found.");
+        table.flush();
+    }
+};
+
+#endif
@@ -0,0 +1,404 @@
+#ifndef CSV_IMPORT_H
+#define CSV_IMPORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file_io.h"
+#include "inventory.h"
+#include "item.h"
+#include "mapped_file.h"
+#include "number_parser.h"
+
+// Bulk import of id,name,quantity,price,category rows from a CSV or TSV file.
+//
+// The file is memory-mapped and cut into chunks of about chunkBytes, each
+// ending at a row boundary. Worker threads parse chunks into Items while the
+// calling thread collects finished chunks, in file order, and hands them to
+// Inventory::insertItems. At most a few chunks per thread are parsed ahead.
+// Each insert batch is at least as large as the inventory already is, so
+// the sorted indexes are merged O(log n) times rather than once per chunk.
+//
+// Rows follow RFC 4180: fields may be quoted, with "" for a quote, and a
+// quoted field may span lines. A quote anywhere but at the start of a field
+// is an ordinary character, as in 55" TV. A first row starting with the field "id" is
+// taken as a header. Rows are checked with the same rules as the Add Item
+// prompts (alphanumeric ID, positive price, category 1 to 3), except that a
+// quantity of zero is accepted: stock adjustments can leave an item at zero,
+// and an export of such an inventory must import again.
+// Rows whose ID is already in the inventory (or earlier in the file) are
+// skipped and counted as duplicates.
+
+struct ImportReport {
+    uint64_t rows = 0;       // data rows read (header and blank lines excluded)
+    uint64_t imported = 0;
+    uint64_t rejected = 0;   // rows failing validation
+    uint64_t duplicates = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+    // "line N: reason" for the first few rejected rows
+    std::vector<std::string> rejections;
+
+    double rowsPerSecond() const { return seconds > 0 ? rows / seconds : 0; }
+};
+
+class CsvImporter {
+private:
+    static const size_t fieldCount = 5;
+    static const size_t maxRejections = 10;
+
+    struct Field {
+        const char* text;
+        size_t length;
+    };
+
+    struct Rejection {
+        uint64_t line; // within the chunk
+        const char* reason;
+    };
+
+    struct Chunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<Item> items;
+        std::vector<Rejection> rejections;
+        uint64_t rows = 0;
+        uint64_t rejected = 0;
+        uint64_t lines = 0;
+        bool ready = false;
+    };
+
+    char delimiter;
+    unsigned threads;
+    size_t chunkBytes = 8u << 20;
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+    static Field trim(Field field) {
+        while (field.length > 0 && isSpace(field.text[0])) {
+            ++field.text;
+            --field.length;
+        }
+        while (field.length > 0 && isSpace(field.text[field.length - 1])) --field.length;
+        return field;
+    }
+
+    static bool isHeader(Field field) {
+        field = trim(field);
+        return field.length == 2 && foldIdChar(field.text[0]) == 'i' && foldIdChar(field.text[1]) == 'd';
+    }
+
+    // Whether path ends in extension (lower case, with its dot), in any case
+    static bool hasExtension(const std::string& path, const char* extension) {
+        size_t length = std::strlen(extension);
+        if (path.length() < length) return false;
+        const char* tail = path.data() + path.length() - length;
+        for (size_t i = 0; i < length; ++i) {
+            if (std::tolower(static_cast<unsigned char>(tail[i])) != extension[i]) return false;
+        }
+        return true;
+    }
+
+    static const char* validate(Field fields[], size_t count, int& quantity, double& price, int& category) {
+        if (count != fieldCount) return "expected 5 fields";
+        Field id = trim(fields[0]);
+        if (!validItemId(id.text, id.length)) return "invalid item ID";
+        Field number = trim(fields[2]);
+        if (!parseInt(number.text, number.text + number.length, quantity) || quantity < 0) {
+            return "quantity must be a non-negative integer";
+        }
+        number = trim(fields[3]);
+        if (!parseDouble(number.text, number.text + number.length, price) || !(price > 0)) {
+            return "price must be a positive number";
+        }
+        number = trim(fields[4]);
+        if (!parseInt(number.text, number.text + number.length, category) || category < 1 ||
+            category > categoryCount) {
+            return "category must be 1, 2 or 3";
+        }
+        return nullptr;
+    }
+
+    // Parse the rows of chunk; it starts at a row boundary
+    void parse(Chunk& chunk, bool first) const {
+        Field fields[fieldCount];
+        std::string unquoted[fieldCount + 1]; // the extra one takes surplus fields
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+
+        while (p < end) {
+            uint64_t line = chunk.lines;
+            size_t count = 0;
+            bool malformed = false;
+            while (true) {
+                Field field;
+                if (p < end && *p == '"') {
+                    // Quoted field: copy it out, undoubling quotes
+                    std::string* text = &unquoted[count < fieldCount ? count : fieldCount];
+                    text->clear();
+                    ++p;
+                    while (true) {
+                        const char* run = p;
+                        while (p < end && *p != '"') {
+                            if (*p == '\n') ++chunk.lines;
+                            ++p;
+                        }
+                        text->append(run, p);
+                        if (p + 1 < end && p[1] == '"') {
+                            text->push_back('"');
+                            p += 2;
+                        } else {
+                            break;
+                        }
+                    }
+                    if (p < end) ++p; // closing quote
+                    field = Field{text->data(), text->length()};
+                    if (p < end && *p != delimiter && *p != '\r' && *p != '\n') malformed = true;
+                    while (p < end && *p != delimiter && *p != '\n') ++p;
+                } else {
+                    const char* start = p;
+                    while (p < end && *p != delimiter && *p != '\n') ++p;
+                    field = Field{start, static_cast<size_t>(p - start)};
+                }
+                if (count < fieldCount) fields[count] = field;
+                ++count;
+                if (p < end && *p == delimiter) {
+                    ++p;
+                    continue;
+                }
+                break;
+            }
+            if (p < end) {
+                ++p; // newline
+                ++chunk.lines;
+            }
+            // CRLF line endings
+            Field& last = fields[(count < fieldCount ? count : fieldCount) - 1];
+            if (last.length > 0 && last.text[last.length - 1] == '\r') --last.length;
+
+            if (count == 1 && fields[0].length == 0) continue; // blank line
+            if (first) {
+                first = false;
+                if (isHeader(fields[0])) continue;
+            }
+
+            ++chunk.rows;
+            int quantity = 0;
+            int category = 0;
+            double price = 0;
+            const char* reason = malformed ? "text after closing quote" : validate(fields, count, quantity, price, category);
+            if (reason != nullptr) {
+                if (chunk.rejections.size() < maxRejections) chunk.rejections.push_back(Rejection{line, reason});
+                ++chunk.rejected;
+                continue;
+            }
+            Field id = trim(fields[0]);
+            chunk.items.emplace_back(TextView(id.text, id.length), TextView(fields[1].text, fields[1].length),
+                                     quantity, price, static_cast<Category>(category));
+        }
+    }
+
+    // Where split() is in a row, by the rules parse() applies: a quote opens
+    // a quoted field only as the first character of a field (elsewhere it is
+    // text), and inside one "" is a quote and a lone " closes it
+    enum QuoteState : uint8_t { FieldStart, Unquoted, Quoted, QuoteSeen };
+    static const size_t quoteStates = 4;
+
+    QuoteState step(QuoteState state, char c) const {
+        switch (state) {
+            case FieldStart:
+                if (c == '"') return Quoted;
+                break;
+            case Unquoted:
+                break;
+            case Quoted:
+                return c == '"' ? QuoteSeen : Quoted;
+            case QuoteSeen:
+                if (c == '"') return Quoted;
+                break;
+        }
+        return c == delimiter || c == '\n' ? FieldStart : Unquoted;
+    }
+
+    // The state at end for each state at begin
+    void transitions(const char* begin, const char* end, QuoteState* after) const {
+        QuoteState states[quoteStates] = {FieldStart, Unquoted, Quoted, QuoteSeen};
+        const char* p = begin;
+        for (; p < end; ++p) {
+            for (size_t s = 0; s < quoteStates; ++s) states[s] = step(states[s], *p);
+            if (states[0] == states[1] && states[1] == states[2] && states[2] == states[3]) {
+                ++p;
+                break;
+            }
+        }
+        // Once every start state has led to the same state, one is enough
+        QuoteState merged = states[0];
+        for (; p < end; ++p) merged = step(merged, *p);
+        for (size_t s = 0; s < quoteStates; ++s) after[s] = states[s] == states[0] ? merged : states[s];
+    }
+
+    // Split data into chunks of about chunkBytes that end at row boundaries,
+    // where a newline inside a quoted field is not a boundary. The state at
+    // each nominal cut comes from every stretch's transitions, found in
+    // parallel.
+    std::vector<Chunk> split(const char* data, size_t size) const {
+        size_t nominal = (size + chunkBytes - 1) / chunkBytes;
+        std::vector<QuoteState> after(nominal * quoteStates);
+        std::vector<std::thread> workers;
+        std::atomic<size_t> next(0);
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (size_t i = next++; i < nominal; i = next++) {
+                    const char* begin = data + i * chunkBytes;
+                    const char* end = data + std::min(size, (i + 1) * chunkBytes);
+                    transitions(begin, end, &after[i * quoteStates]);
+                }
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+
+        std::vector<Chunk> chunks;
+        const char* begin = data;
+        const char* end = data + size;
+        QuoteState state = FieldStart; // at the nominal cut
+        for (size_t i = 1; i < nominal; ++i) {
+            state = after[(i - 1) * quoteStates + state];
+            const char* cut = data + i * chunkBytes;
+            if (cut < begin) continue; // a quoted field ran past this cut
+            QuoteState at = state;
+            bool boundary = false;
+            while (cut < end && !boundary) {
+                boundary = *cut == '\n' && at != Quoted;
+                at = step(at, *cut);
+                ++cut;
+            }
+            if (!boundary) break;
+            chunks.emplace_back();
+            chunks.back().begin = begin;
+            chunks.back().end = cut;
+            begin = cut;
+        }
+        if (begin < end) {
+            chunks.emplace_back();
+            chunks.back().begin = begin;
+            chunks.back().end = end;
+        }
+        return chunks;
+    }
+
+public:
+    // delimiter 0 picks tab for .tsv files or a tab-separated first line,
+    // comma otherwise; threads 0 uses every hardware thread
+    explicit CsvImporter(char delimiter = 0, unsigned threads = 0) : delimiter(delimiter), threads(threads) {
+        if (this->threads == 0) this->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void setChunkBytes(size_t bytes) { chunkBytes = std::max<size_t>(bytes, 1); }
+
+    bool import(Inventory& inventory, const std::string& path, ImportReport& report, std::string& error) {
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        report = ImportReport();
+
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            error = "cannot open " + path;
+            return false;
+        }
+        uint64_t size = 0;
+        bool sized = fileSize(file, size);
+        fclose(file);
+        if (!sized) {
+            error = "cannot read " + path;
+            return false;
+        }
+        if (size == 0) return true;
+
+        MappedFile mapped;
+        if (!mapped.open(path, error)) return false;
+        const char* data = mapped.data();
+        report.bytes = size;
+
+        char separator = delimiter;
+        if (separator == 0) {
+            const char* lineEnd = std::find(data, data + size, '\n');
+            bool tabs = std::find(data, lineEnd, '\t') != lineEnd && std::find(data, lineEnd, ',') == lineEnd;
+            separator = hasExtension(path, ".tsv") || tabs ? '\t' : ',';
+        }
+        CsvImporter parser(separator, threads);
+        parser.chunkBytes = chunkBytes;
+
+        std::vector<Chunk> chunks = parser.split(data, static_cast<size_t>(size));
+        std::mutex lock;
+        std::condition_variable changed;
+        std::atomic<size_t> next(0);
+        size_t inserted = 0;        // chunks handed to the inventory
+        const size_t window = 2 * static_cast<size_t>(threads);
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (size_t i = next++; i < chunks.size(); i = next++) {
+                    {
+                        std::unique_lock<std::mutex> guard(lock);
+                        changed.wait(guard, [&] { return i < inserted + window; });
+                    }
+                    parser.parse(chunks[i], i == 0);
+                    std::lock_guard<std::mutex> guard(lock);
+                    chunks[i].ready = true;
+                    changed.notify_all();
+                }
+            });
+        }
+
+        uint64_t line = 1;
+        std::vector<Item> batch;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            Chunk& chunk = chunks[i];
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [&] { return chunk.ready; });
+            }
+            if (batch.empty()) {
+                batch.swap(chunk.items);
+            } else {
+                batch.insert(batch.end(), std::make_move_iterator(chunk.items.begin()),
+                             std::make_move_iterator(chunk.items.end()));
+            }
+            if (batch.size() >= static_cast<size_t>(inventory.getItemCount()) || i + 1 == chunks.size()) {
+                size_t added = inventory.insertItems(batch);
+                report.imported += added;
+                report.duplicates += batch.size() - added;
+                std::vector<Item>().swap(batch);
+            }
+            report.rows += chunk.rows;
+            report.rejected += chunk.rejected;
+            for (const Rejection& rejection : chunk.rejections) {
+                if (report.rejections.size() == maxRejections) break;
+                report.rejections.push_back("line " + std::to_string(line + rejection.line) + ": " + rejection.reason);
+            }
+            line += chunk.lines;
+            std::vector<Item>().swap(chunk.items);
+
+            std::lock_guard<std::mutex> guard(lock);
+            ++inserted;
+            changed.notify_all();
+        }
+        for (std::thread& worker : workers) worker.join();
+
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return true;
+    }
+};
+
+#endif
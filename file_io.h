@@ -0,0 +1,130 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+// Small portable wrappers around stdio used by the persistence code
+
+inline bool writeBytes(FILE* file, const void* data, size_t size) {
+    return fwrite(data, 1, size, file) == size;
+}
+
+inline bool readBytes(FILE* file, void* data, size_t size) {
+    return fread(data, 1, size, file) == size;
+}
+
+inline bool seekFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// Size of an open file; leaves the position at the end
+inline bool fileSize(FILE* file, uint64_t& size) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) return false;
+    long long end = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) return false;
+    off_t end = ftello(file);
+#endif
+    if (end < 0) return false;
+    size = static_cast<uint64_t>(end);
+    return true;
+}
+
+// Flush stdio buffers and force the data to stable storage
+inline bool syncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Create or truncate a file for writing; returns a descriptor, or -1
+inline int openOutputFile(const std::string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+inline int openInputFile(const std::string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    return open(path.c_str(), O_RDONLY);
+#endif
+}
+
+inline bool closeFile(int fd) {
+#ifdef _WIN32
+    return _close(fd) == 0;
+#else
+    return close(fd) == 0;
+#endif
+}
+
+inline bool fileExists(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    fclose(file);
+    return true;
+}
+
+// Rename from over to, replacing any existing file
+inline bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    std::remove(to.c_str());
+#endif
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+// Force a rename into path's directory to stable storage. Windows has no
+// directory handles to sync, so there this only reports success.
+inline bool syncDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    std::string::size_type slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+// Cut the file at path down to size bytes and sync it
+inline bool truncateFile(const std::string& path, uint64_t size) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_BINARY);
+    if (fd < 0) return false;
+    bool ok = _chsize_s(fd, static_cast<long long>(size)) == 0 && _commit(fd) == 0;
+    return _close(fd) == 0 && ok;
+#else
+    int fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0) return false;
+    bool ok = ftruncate(fd, static_cast<off_t>(size)) == 0 && fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+#endif
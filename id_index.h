@@ -0,0 +1,125 @@
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "item.h"
+#include "item_store.h"
+
+// Open-addressing hash map from item ID to ItemHandle.
+//
+// Linear probing over a power-of-two table kept at most 70% full. Erase uses
+// backward-shift deletion, so there are no tombstones and probe sequences
+// never degrade under add/remove churn.
+//
+// Buckets hold only the hash and the handle; keys are the IDs the items
+// already carry, so the store is passed to every operation. IDs are
+// case-folded while hashing and comparing, never copied.
+class IdIndex {
+private:
+    struct Entry {
+        uint32_t hash = 0; // 0 marks an empty bucket; stored hashes are never 0
+        ItemHandle handle = ItemHandle{0, 0};
+    };
+
+    std::vector<Entry> buckets;
+    size_t count = 0;
+
+    static uint32_t hashId(TextView id) {
+        return hashItemId(id.data(), id.length()) | 1u;
+    }
+
+    size_t mask() const { return buckets.size() - 1; }
+
+    // Bucket holding id, or the empty bucket where it would go
+    size_t probe(const ItemStore& store, TextView id, uint32_t hash) const {
+        size_t i = hash & mask();
+        while (buckets[i].hash != 0 &&
+               (buckets[i].hash != hash || !store.get(buckets[i].handle)->hasId(id))) {
+            i = (i + 1) & mask();
+        }
+        return i;
+    }
+
+    // Empty bucket for a hash known not to be present
+    size_t probeEmpty(uint32_t hash) const {
+        size_t i = hash & mask();
+        while (buckets[i].hash != 0) {
+            i = (i + 1) & mask();
+        }
+        return i;
+    }
+
+    void rehash(size_t bucketCount) {
+        std::vector<Entry> old(bucketCount);
+        old.swap(buckets);
+        for (const Entry& entry : old) {
+            if (entry.hash != 0) {
+                buckets[probeEmpty(entry.hash)] = entry;
+            }
+        }
+    }
+
+public:
+    IdIndex() : buckets(16) {}
+
+    size_t size() const { return count; }
+
+    // Make room for count entries without rehashing
+    void reserve(size_t entries) {
+        size_t needed = buckets.size();
+        while (entries * 10 > needed * 7) needed *= 2;
+        if (needed != buckets.size()) rehash(needed);
+    }
+
+    void clear() {
+        buckets.assign(16, Entry());
+        count = 0;
+    }
+
+    // Look up an ID in any case; returns false when it is not indexed
+    bool find(const ItemStore& store, TextView id, ItemHandle& handle) const {
+        size_t i = probe(store, id, hashId(id));
+        if (buckets[i].hash == 0) return false;
+        handle = buckets[i].handle;
+        return true;
+    }
+
+    // Index an item under its key; returns false if the ID is already present
+    bool insert(const ItemStore& store, ItemHandle handle) {
+        reserve(count + 1);
+        TextView id = store.get(handle)->getId();
+        uint32_t hash = hashId(id);
+        size_t i = probe(store, id, hash);
+        if (buckets[i].hash != 0) return false;
+        buckets[i].hash = hash;
+        buckets[i].handle = handle;
+        ++count;
+        return true;
+    }
+
+    // Must be called before the item is removed from the store
+    bool erase(const ItemStore& store, TextView id) {
+        size_t i = probe(store, id, hashId(id));
+        if (buckets[i].hash == 0) return false;
+
+        // Shift later members of the probe run back so lookups never hit a gap
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask();
+            if (buckets[j].hash == 0) break;
+            size_t home = buckets[j].hash & mask();
+            bool between = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!between) {
+                buckets[i] = buckets[j];
+                i = j;
+            }
+        }
+        buckets[i].hash = 0;
+        --count;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,618 @@
+#ifndef INVENTORY_H
+#define INVENTORY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "category_index.h"
+#include "id_index.h"
+#include "item.h"
+#include "item_scan.h"
+#include "item_sorter.h"
+#include "item_store.h"
+#include "low_stock_index.h"
+#include "operation_stats.h"
+#include "sorted_index.h"
+#include "table_writer.h"
+
+// Receives every change made to an Inventory, right after it is applied.
+// Used to journal changes; see Journal.
+class InventoryObserver {
+public:
+    virtual ~InventoryObserver() = default;
+    virtual void itemAdded(const Item& item) = 0;
+    virtual void quantityChanged(const Item& item) = 0;
+    virtual void priceChanged(const Item& item) = 0;
+    // Called just before the item is removed
+    virtual void itemRemoved(const Item& item) = 0;
+    virtual void inventoryCleared() = 0;
+};
+
+// Result of a programmatic update; the item is unchanged unless it is Ok
+enum class UpdateStatus : uint8_t {
+    Ok,
+    NotFound,
+    InvalidValue,      // negative quantity or non-positive price
+    InsufficientStock, // the adjustment would take the quantity below zero
+    ReadOnly
+};
+
+inline const char* updateStatusMessage(UpdateStatus status) {
+    switch (status) {
+        case UpdateStatus::Ok: return "ok";
+        case UpdateStatus::NotFound: return "item not found";
+        case UpdateStatus::InvalidValue: return "invalid value";
+        case UpdateStatus::InsufficientStock: return "insufficient stock";
+        case UpdateStatus::ReadOnly: return "inventory is read-only";
+    }
+    return "";
+}
+
+enum class UpdateKind : uint8_t {
+    SetQuantity,
+    AdjustQuantity,
+    SetPrice
+};
+
+// One entry of a batched update
+struct ItemUpdate {
+    std::string id;
+    UpdateKind kind;
+    int quantity; // new quantity, or the change for AdjustQuantity
+    double price;
+};
+
+class InventoryBase {
+protected:
+    // listings are rendered through a reusable buffer
+    FileSink standardOutput{stdout};
+    TableWriter table{standardOutput};
+
+    void writeHeader(bool withCategory, const char* separator) {
+        table.cell("ID", 10);
+        table.cell("Name", 20);
+        table.cell("Quantity", 10);
+        table.cell("Price", 10);
+        if (withCategory) table.cell("Category", 15);
+        table.text("\n");
+        table.line(separator);
+    }
+
+    void writeFullHeader() {
+        writeHeader(true, "---------------------------------------------------------------------");
+    }
+
+    void writeSortedHeader() {
+        writeHeader(true, "----------------------------------------------------------");
+    }
+
+    void writeCategoryHeader() {
+        writeHeader(false, "----------------------------------------------------------");
+    }
+
+    // Ask whether to update the quantity or the price, and for its new value
+    UpdateKind promptUpdate(int& newQuantity, double& newPrice) {
+        int choice;
+        while (true) {
+            std::cout << "\n[1] Update Quantity\n[2] Update Price\nEnter choice: ";
+            std::cin >> choice;
+
+            if (std::cin.fail() || (choice != 1 && choice != 2)) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cout << "Invalid choice! Please enter 1 or 2." << std::endl;
+            } else {
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                break;
+            }
+        }
+
+        if (choice == 1) {
+            while (true) {
+                std::cout << "Enter new quantity: ";
+                std::cin >> newQuantity;
+
+                if (std::cin.fail() || newQuantity <= 0) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input. Please enter a positive integer." << std::endl;
+                } else {
+                    return UpdateKind::SetQuantity;
+                }
+            }
+        }
+        while (true) {
+            std::cout << "Enter new price: ";
+            std::cin >> newPrice;
+
+            if (std::cin.fail() || newPrice <= 0) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cout << "Invalid input. Please enter a positive number." << std::endl;
+            } else {
+                return UpdateKind::SetPrice;
+            }
+        }
+    }
+
+    void reportQuantityUpdate(const Item& item, int newQuantity) const {
+        std::cout << "Quantity of Item " << item.getName() << " is updated from " << item.getQuantity() << " to " << newQuantity << std::endl;
+    }
+
+    void reportPriceUpdate(const Item& item, double newPrice) const {
+        std::cout << "Price of Item " << item.getName() << " is updated from " << item.getPrice() << " to " << newPrice << std::endl;
+    }
+
+public:
+    InventoryBase() = default;
+    virtual ~InventoryBase() = default;
+
+    InventoryBase(const InventoryBase&) = delete;
+    InventoryBase& operator=(const InventoryBase&) = delete;
+
+    virtual int getItemCount() const = 0;
+
+    // Send item listings to another sink (standard output by default)
+    void setOutput(OutputSink& sink) { table.setSink(sink); }
+
+    bool isValidCategory(int category) const {
+        return category >= 1 && category <= 3;
+    }
+
+    // Category names are static strings, shared by every item
+    const char* categoryToString(int category) const {
+        return isValidCategory(category) ? categoryName(static_cast<Category>(category)) : "";
+    }
+
+    // virtual functions
+    virtual void addItem(TextView id, TextView name, int quantity, double price, int category) = 0;
+
+    virtual void updateItem(TextView id) = 0;
+
+    // Non-interactive updates. A quantity may be zero (out of stock) but
+    // not negative; a price must be positive.
+    virtual UpdateStatus setQuantity(TextView id, int quantity) = 0;
+    virtual UpdateStatus adjustQuantity(TextView id, int delta) = 0;
+    virtual UpdateStatus setPrice(TextView id, double price) = 0;
+
+    // Apply count updates in order, storing each one's status in statuses
+    // (unless it is null); returns how many were applied
+    virtual size_t applyUpdates(const ItemUpdate* updates, size_t count, UpdateStatus* statuses) {
+        size_t applied = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const ItemUpdate& update = updates[i];
+            UpdateStatus status = update.kind == UpdateKind::SetQuantity ? setQuantity(update.id, update.quantity)
+                                : update.kind == UpdateKind::AdjustQuantity ? adjustQuantity(update.id, update.quantity)
+                                : setPrice(update.id, update.price);
+            if (status == UpdateStatus::Ok) ++applied;
+            if (statuses != nullptr) statuses[i] = status;
+        }
+        return applied;
+    }
+
+    virtual void removeItem(TextView id) = 0;
+
+    virtual void displayItemsByCategory(int category) = 0;
+
+    virtual void displayAllItems() = 0;
+
+    virtual void searchItem(TextView id) = 0;
+
+    virtual void sortItems(bool byQuantity, bool ascending) = 0;
+
+    // Sort on several keys, most significant first (e.g. category, then price)
+    virtual void sortItems(const std::vector<SortKey>& keys) = 0;
+
+    // Display the first count items by quantity or price
+    virtual void displayTopItems(bool byQuantity, bool ascending, int count) = 0;
+
+    bool isEmpty() const {
+        return getItemCount() == 0;
+    }
+
+    virtual void displayLowStockItems() = 0;
+};
+
+class Inventory: public InventoryBase {
+private:
+    ItemStore items;
+    // item ID (any case) -> item
+    IdIndex index;
+    // items ordered by quantity and by price, maintained on every change
+    SortedIndex<int> quantityIndex;
+    SortedIndex<double> priceIndex;
+    // items of each category
+    CategoryIndex categoryIndex;
+    // items at or below their category's low-stock threshold
+    LowStockIndex lowStock;
+    ItemSorter sorter;
+    InventoryObserver* observer = nullptr;
+
+    bool findHandle(TextView id, ItemHandle& handle) const {
+        return index.find(items, id, handle);
+    }
+
+    const Item* findItem(TextView id) const {
+        ItemHandle handle;
+        if (!findHandle(id, handle)) return nullptr;
+        return items.get(handle);
+    }
+
+    bool containsId(const Item& item) const {
+        ItemHandle handle;
+        return index.find(items, item.getId(), handle);
+    }
+
+    // Store an item and add it to every index except the sorted ones
+    ItemHandle storeItem(Item&& item) {
+        ItemHandle handle = items.add(std::move(item));
+        const Item* added = items.get(handle);
+        index.insert(items, handle);
+        categoryIndex.insert(added->getCategory(), handle);
+        lowStock.update(handle, *added);
+        if (observer != nullptr) observer->itemAdded(*added);
+        return handle;
+    }
+
+    // With indexed false the sorted indexes are left stale, to be rebuilt
+    // by rebuildSortedIndexes
+    void setItemQuantity(ItemHandle handle, int newQuantity, bool indexed = true) {
+        if (indexed) quantityIndex.erase(items.get(handle)->getQuantity(), handle);
+        const Item& item = items.setQuantity(handle, newQuantity);
+        if (indexed) quantityIndex.insert(newQuantity, handle);
+        lowStock.update(handle, item);
+        if (observer != nullptr) observer->quantityChanged(item);
+    }
+
+    void setItemPrice(ItemHandle handle, double newPrice, bool indexed = true) {
+        if (indexed) priceIndex.erase(items.get(handle)->getPrice(), handle);
+        const Item& item = items.setPrice(handle, newPrice);
+        if (indexed) priceIndex.insert(newPrice, handle);
+        if (observer != nullptr) observer->priceChanged(item);
+    }
+
+    void rebuildSortedIndexes() {
+        std::vector<SortedIndex<int>::Entry> quantities;
+        std::vector<SortedIndex<double>::Entry> prices;
+        quantities.reserve(items.size());
+        prices.reserve(items.size());
+        const int* quantity = items.quantityColumn();
+        const double* price = items.priceColumn();
+        for (size_t i = 0; i < items.size(); ++i) {
+            ItemHandle handle = items.handleAt(i);
+            quantities.push_back(SortedIndex<int>::Entry{quantity[i], handle});
+            prices.push_back(SortedIndex<double>::Entry{price[i], handle});
+        }
+        quantityIndex.clear();
+        quantityIndex.insertBatch(quantities);
+        priceIndex.clear();
+        priceIndex.insertBatch(prices);
+    }
+
+    UpdateStatus update(TextView id, UpdateKind kind, int quantity, double price, bool indexed) {
+        TIME_OPERATION(Operation::Update);
+        ItemHandle handle;
+        if (!findHandle(id, handle)) return UpdateStatus::NotFound;
+        if (kind == UpdateKind::SetPrice) {
+            if (!(price > 0) || !std::isfinite(price)) return UpdateStatus::InvalidValue;
+            setItemPrice(handle, price, indexed);
+            return UpdateStatus::Ok;
+        }
+        long long newQuantity = quantity;
+        if (kind == UpdateKind::AdjustQuantity) {
+            newQuantity += items.get(handle)->getQuantity();
+            if (newQuantity < 0) return UpdateStatus::InsufficientStock;
+        }
+        if (newQuantity < 0 || newQuantity > std::numeric_limits<int>::max()) return UpdateStatus::InvalidValue;
+        setItemQuantity(handle, static_cast<int>(newQuantity), indexed);
+        return UpdateStatus::Ok;
+    }
+
+    void eraseHandle(ItemHandle handle) {
+        const Item* item = items.get(handle);
+        if (observer != nullptr) observer->itemRemoved(*item);
+        index.erase(items, item->getId());
+        quantityIndex.erase(item->getQuantity(), handle);
+        priceIndex.erase(item->getPrice(), handle);
+        categoryIndex.erase(item->getCategory(), handle);
+        lowStock.erase(handle);
+        items.remove(handle);
+    }
+
+    // Walk an ordered index, forwards or backwards, displaying up to count items
+    template <typename Index>
+    void displayFromIndex(const Index& sorted, bool ascending, size_t count) {
+        writeSortedHeader();
+        if (ascending) {
+            for (auto it = sorted.begin(); it != sorted.end() && count > 0; ++it, --count) {
+                items.get(it->handle)->displayItem(table);
+            }
+        } else {
+            for (auto it = sorted.rbegin(); it != sorted.rend() && count > 0; ++it, --count) {
+                items.get(it->handle)->displayItem(table);
+            }
+        }
+        table.flush();
+    }
+
+public:
+    int getItemCount() const override { return static_cast<int>(items.size()); }
+
+    // Bytes used by the item storage, including the items' text
+    size_t memoryUsage() const { return items.memoryUsage(); }
+
+    ItemStoreStats storeStats() const { return items.stats(); }
+
+    // Add new item to inventory
+    void addItem(TextView id, TextView name, int quantity, double price, int category) override {
+        if (!isValidCategory(category)) {
+            std::cout << "Category does not exist!" << std::endl;
+            return;
+        }
+
+        if (!insertItem(Item(id, name, quantity, price, static_cast<Category>(category)))) {
+            std::cout << "Item ID already exists!" << std::endl;
+            return;
+        }
+        std::cout << "Item added successfully!" << std::endl;
+    }
+
+    // Add an item without printing anything; returns false if its ID is taken
+    bool insertItem(Item item) {
+        TIME_OPERATION(Operation::Add);
+        if (containsId(item)) return false;
+
+        ItemHandle handle = storeItem(std::move(item));
+        const Item* added = items.get(handle);
+        quantityIndex.insert(added->getQuantity(), handle);
+        priceIndex.insert(added->getPrice(), handle);
+        return true;
+    }
+
+    // Add a batch of items, skipping IDs that are taken; returns the number
+    // added. The sorted indexes are updated once for the whole batch.
+    size_t insertItems(std::vector<Item>& batch) {
+        std::vector<SortedIndex<int>::Entry> quantities;
+        std::vector<SortedIndex<double>::Entry> prices;
+        quantities.reserve(batch.size());
+        prices.reserve(batch.size());
+        // Grow geometrically so a stream of batches does not reallocate the
+        // store on every call
+        size_t needed = items.size() + batch.size();
+        if (needed > items.capacity()) reserve(std::max(needed, 2 * items.size()));
+
+        for (Item& item : batch) {
+            if (containsId(item)) continue;
+            ItemHandle handle = storeItem(std::move(item));
+            const Item* added = items.get(handle);
+            quantities.push_back(SortedIndex<int>::Entry{added->getQuantity(), handle});
+            prices.push_back(SortedIndex<double>::Entry{added->getPrice(), handle});
+        }
+        quantityIndex.insertBatch(quantities);
+        priceIndex.insertBatch(prices);
+        return quantities.size();
+    }
+
+    UpdateStatus setQuantity(TextView id, int quantity) override {
+        return update(id, UpdateKind::SetQuantity, quantity, 0, true);
+    }
+
+    UpdateStatus adjustQuantity(TextView id, int delta) override {
+        return update(id, UpdateKind::AdjustQuantity, delta, 0, true);
+    }
+
+    UpdateStatus setPrice(TextView id, double price) override {
+        return update(id, UpdateKind::SetPrice, 0, price, true);
+    }
+
+    // A batch touching more than an eighth of the items skips the per-item
+    // sorted index maintenance and rebuilds both indexes once at the end
+    size_t applyUpdates(const ItemUpdate* updates, size_t count, UpdateStatus* statuses) override {
+        bool rebuild = count > items.size() / 8;
+        size_t applied = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const ItemUpdate& entry = updates[i];
+            UpdateStatus status = update(entry.id, entry.kind, entry.quantity, entry.price, !rebuild);
+            if (status == UpdateStatus::Ok) ++applied;
+            if (statuses != nullptr) statuses[i] = status;
+        }
+        if (rebuild && applied > 0) rebuildSortedIndexes();
+        return applied;
+    }
+
+    // Quiet counterpart of removeItem; returns false when the ID is not found
+    bool eraseItem(TextView id) {
+        TIME_OPERATION(Operation::Remove);
+        ItemHandle handle;
+        if (!findHandle(id, handle)) return false;
+        eraseHandle(handle);
+        return true;
+    }
+
+    // Remove every item
+    void clear() {
+        if (observer != nullptr) observer->inventoryCleared();
+        index.clear();
+        quantityIndex.clear();
+        priceIndex.clear();
+        categoryIndex.clear();
+        lowStock.clear();
+        items.clear();
+    }
+
+    // Make room for count items, e.g. before a bulk load
+    void reserve(size_t count) {
+        items.reserve(count);
+        index.reserve(count);
+    }
+
+    const ItemStore& getItems() const { return items; }
+
+    // Item with the given ID in any case, or nullptr
+    const Item* getItem(TextView id) const {
+        ItemHandle handle;
+        return findHandle(id, handle) ? items.get(handle) : nullptr;
+    }
+
+    // Report every change to observer (nullptr to stop)
+    void setObserver(InventoryObserver* newObserver) { observer = newObserver; }
+    const SortedIndex<int>& getQuantityIndex() const { return quantityIndex; }
+    const SortedIndex<double>& getPriceIndex() const { return priceIndex; }
+    const std::vector<ItemHandle>& getCategoryMembers(Category category) const { return categoryIndex.members(category); }
+
+    // Update item quantity or price
+    void updateItem(TextView id) override  {
+        ItemHandle handle;
+        if (!findHandle(id, handle)) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        const Item* item = items.get(handle);
+
+        int newQuantity;
+        double newPrice;
+        UpdateKind kind = promptUpdate(newQuantity, newPrice);
+        TIME_OPERATION(Operation::Update); // not the prompt
+        if (kind == UpdateKind::SetQuantity) {
+            reportQuantityUpdate(*item, newQuantity);
+            setItemQuantity(handle, newQuantity);
+        } else {
+            reportPriceUpdate(*item, newPrice);
+            setItemPrice(handle, newPrice);
+        }
+    }
+
+    // Remove item from inventory
+    void removeItem(TextView id) override {
+        TIME_OPERATION(Operation::Remove);
+        ItemHandle handle;
+        if (!findHandle(id, handle)) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        std::cout << "Item " << items.get(handle)->getName() << " has been removed from the inventory." << std::endl;
+        eraseHandle(handle);
+    }
+
+    // Display all items by category
+    void displayItemsByCategory(int category) override {
+        TIME_OPERATION(Operation::ListCategory);
+        if (!isValidCategory(category)) {
+            std::cout << "Category does not exist!" << std::endl;
+            return;
+        }
+
+        const std::vector<ItemHandle>& members = categoryIndex.members(static_cast<Category>(category));
+        writeCategoryHeader();
+        for (ItemHandle handle : members) {
+            items.get(handle)->displayItem(table);
+        }
+        if (members.empty()) table.line("No items found in this category.");
+        table.flush();
+    }
+
+    // Display all items in a table format
+    void displayAllItems() override {
+        TIME_OPERATION(Operation::ListAll);
+        if (items.empty()) {
+            std::cout << "No items in the inventory." << std::endl;
+        } else {
+            writeFullHeader();
+            for (const Item& item : items) {
+                item.displayItem(table);
+            }
+            table.flush();
+        }
+    }
+
+    // Search item by ID
+    void searchItem(TextView id) override {
+        TIME_OPERATION(Operation::Search);
+        const Item* item = findItem(id);
+        if (item == nullptr) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        writeFullHeader();
+        item->displayItem(table);
+        table.flush();
+    }
+
+    // Sort items (by quantity or price, ascending or descending)
+    void sortItems(bool byQuantity, bool ascending) override {
+        displayTopItems(byQuantity, ascending, getItemCount());
+    }
+
+    // Ad-hoc orderings without a maintained index are sorted on demand; the
+    // items themselves are not moved
+    void sortItems(const std::vector<SortKey>& keys) override {
+        TIME_OPERATION(Operation::Sort);
+        const std::vector<uint32_t>& order = sorter.order(items, keys.data(), keys.size());
+        writeSortedHeader();
+        for (uint32_t position : order) {
+            items[position].displayItem(table);
+        }
+        table.flush();
+    }
+
+    void displayTopItems(bool byQuantity, bool ascending, int count) override {
+        TIME_OPERATION(Operation::Sort);
+        size_t limit = count > 0 ? static_cast<size_t>(count) : 0;
+        if (byQuantity) {
+            displayFromIndex(quantityIndex, ascending, limit);
+        } else {
+            displayFromIndex(priceIndex, ascending, limit);
+        }
+    }
+
+    // Display the items matching query, in stored order
+    void displayMatchingItems(ItemScanner& scanner, const ItemQuery& query) {
+        TIME_OPERATION(Operation::Find);
+        std::vector<uint32_t> matches = scanner.find(items, query);
+        writeFullHeader();
+        for (uint32_t position : matches) {
+            items[position].displayItem(table);
+        }
+        if (matches.empty()) table.line("No matching items found.");
+        table.flush();
+    }
+
+    // Low-stock threshold for all categories, or for one category
+    void setLowStockThreshold(int threshold) {
+        lowStock.setThreshold(threshold);
+        lowStock.refresh(items);
+    }
+
+    void setLowStockThreshold(Category category, int threshold) {
+        lowStock.setThreshold(category, threshold);
+        lowStock.refresh(items);
+    }
+
+    int getLowStockThreshold(Category category) const { return lowStock.threshold(category); }
+    const std::vector<ItemHandle>& getLowStockMembers() const { return lowStock.members(); }
+
+    // Called whenever an item crosses its low-stock threshold
+    void setLowStockHook(LowStockIndex::Hook hook) { lowStock.setHook(std::move(hook)); }
+
+    // Display low stock items
+    void displayLowStockItems() override {
+        TIME_OPERATION(Operation::LowStock);
+        const std::vector<ItemHandle>& members = lowStock.members();
+        writeFullHeader();
+        for (ItemHandle handle : members) {
+            items.get(handle)->displayItem(table);
+        }
+        if (members.empty()) table.line("No low stock items found.");
+        table.flush();
+    }
+
+};
+
+#endif
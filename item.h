@@ -0,0 +1,212 @@
+#ifndef ITEM_H
+#define ITEM_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "string_arena.h"
+#include "table_writer.h"
+#include "text_view.h"
+
+// Item categories, numbered as in the menu
+enum class Category : uint8_t {
+    Clothing = 1,
+    Electronics = 2,
+    Entertainment = 3
+};
+
+const int categoryCount = 3;
+
+inline const char* categoryName(Category category) {
+    switch (category) {
+        case Category::Clothing: return "Clothing";
+        case Category::Electronics: return "Electronics";
+        case Category::Entertainment: return "Entertainment";
+    }
+    return "";
+}
+
+// One row of an item table: ID, name, quantity, price, category
+inline void displayItemRow(TableWriter& table, const char* id, size_t idLength, const char* name, size_t nameLength,
+                           int quantity, double price, Category category) {
+    table.cell(id, idLength, 10);
+    table.cell(name, nameLength, 20);
+    table.cell(quantity, 10);
+    table.cell(price, 10);
+    table.cell(categoryName(category), 15);
+    table.endRow();
+}
+
+// Item IDs are case-insensitive. Every ID comparison goes through this
+// folding, character by character on both IDs. IDs are ASCII, so this is
+// tolower in the C locale without a library call per character.
+inline char foldIdChar(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Hash of an ID in any case (FNV-1a over the folded characters). Snapshot
+// files store tables built with it, so it must not change.
+inline uint32_t hashItemId(const char* id, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(foldIdChar(id[i]));
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// IDs are non-empty and alphanumeric
+inline bool validItemId(const char* id, size_t length) {
+    if (length == 0) return false;
+    for (size_t i = 0; i < length; ++i) {
+        if (!isalnum(static_cast<unsigned char>(id[i]))) return false;
+    }
+    return true;
+}
+
+inline std::string normalizeItemId(TextView id) {
+    std::string key = id.str();
+    for (size_t i = 0; i < key.length(); ++i) {
+        key[i] = foldIdChar(key[i]);
+    }
+    return key;
+}
+
+class Item {
+private:
+    // Encapsulation: Private attributes, encapsulating the internal state of the item.
+    // The ID followed by the name, in one StringArena allocation
+    char* text = nullptr;
+    uint32_t idBytes = 0;
+    uint32_t nameBytes = 0;
+    int quantity;
+    Category category;
+    double price;
+
+    // Only through ItemStore, which keeps its quantity and price columns in
+    // step with the items
+    friend class ItemStore;
+    void setQuantity(int newQuantity) { quantity = newQuantity; }
+    void setPrice(double newPrice) { price = newPrice; }
+
+    void assignText(const char* id, size_t idLength, const char* name, size_t nameLength) {
+        char* copy = StringArena::allocate(idLength + nameLength);
+        if (idLength > 0) std::memcpy(copy, id, idLength);
+        if (nameLength > 0) std::memcpy(copy + idLength, name, nameLength);
+        StringArena::release(text);
+        text = copy;
+        idBytes = static_cast<uint32_t>(idLength);
+        nameBytes = static_cast<uint32_t>(nameLength);
+    }
+
+public:
+    // Constructor to initialize item; the text is copied into the arena,
+    // so it can come from a std::string or straight from a file buffer
+    Item(TextView id, TextView name, int quantity, double price, Category category)
+            : quantity(quantity), category(category), price(price) {
+        assignText(id.data(), id.length(), name.data(), name.length());
+    }
+
+    Item(const Item& other) : quantity(other.quantity), category(other.category), price(other.price) {
+        assignText(other.text, other.idBytes, other.text + other.idBytes, other.nameBytes);
+    }
+
+    Item(Item&& other) noexcept
+            : text(other.text), idBytes(other.idBytes), nameBytes(other.nameBytes), quantity(other.quantity),
+              category(other.category), price(other.price) {
+        other.text = nullptr;
+        other.idBytes = 0;
+        other.nameBytes = 0;
+    }
+
+    Item& operator=(const Item& other) {
+        if (this != &other) {
+            assignText(other.text, other.idBytes, other.text + other.idBytes, other.nameBytes);
+            quantity = other.quantity;
+            category = other.category;
+            price = other.price;
+        }
+        return *this;
+    }
+
+    Item& operator=(Item&& other) noexcept {
+        if (this != &other) {
+            StringArena::release(text, textBytes());
+            text = other.text;
+            idBytes = other.idBytes;
+            nameBytes = other.nameBytes;
+            quantity = other.quantity;
+            category = other.category;
+            price = other.price;
+            other.text = nullptr;
+            other.idBytes = 0;
+            other.nameBytes = 0;
+        }
+        return *this;
+    }
+
+    ~Item() { StringArena::release(text, textBytes()); }
+
+    // Getter methods; the views stay valid while the item exists and is not
+    // assigned to
+    TextView getId() const { return TextView(text, idBytes); }
+    TextView getName() const { return TextView(text + idBytes, nameBytes); }
+    int getQuantity() const { return quantity; }
+    double getPrice() const { return price; }
+    Category getCategory() const { return category; }
+    const char* getCategoryName() const { return categoryName(category); }
+
+    // Whether the ID equals id, ignoring case
+    bool hasId(TextView id) const {
+        if (id.length() != idBytes) return false;
+        for (size_t i = 0; i < idBytes; ++i) {
+            if (foldIdChar(text[i]) != foldIdChar(id[i])) return false;
+        }
+        return true;
+    }
+
+    // Whether the name contains text, ignoring case; text must already be
+    // folded with normalizeItemId
+    bool nameContains(TextView part) const {
+        const char* name = text + idBytes;
+        if (part.length() > nameBytes) return false;
+        size_t last = nameBytes - part.length();
+        for (size_t start = 0; start <= last; ++start) {
+            size_t i = 0;
+            while (i < part.length() && foldIdChar(name[start + i]) == part[i]) ++i;
+            if (i == part.length()) return true;
+        }
+        return false;
+    }
+
+    // Abstraction
+    // public method to display the items
+    void displayItem(TableWriter& table) const {
+        displayItemRow(table, text, idBytes, text + idBytes, nameBytes, quantity, price, category);
+    }
+
+    // Bytes of StringArena text owned by the item
+    size_t textBytes() const { return idBytes + nameBytes; }
+
+    // Hand the text block over to the caller, who must release it; the
+    // item is left with an empty ID and name
+    char* detachText() {
+        char* block = text;
+        text = nullptr;
+        idBytes = 0;
+        nameBytes = 0;
+        return block;
+    }
+
+    // Move the text into block, an unused StringArena block of the same
+    // block size; the item takes over the block's reference
+    void moveTextTo(char* block) {
+        std::memcpy(block, text, textBytes());
+        StringArena::release(text, textBytes());
+        text = block;
+    }
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef ITEM_EXPORT_H
+#define ITEM_EXPORT_H
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "inventory.h"
+#include "item.h"
+#include "table_writer.h"
+
+// Streams the items of an Inventory as CSV or JSON Lines.
+//
+// Items are read straight from the store or one of the inventory's indexes
+// and written through a TableWriter in 1 MiB blocks, so memory use does not
+// depend on the inventory size. CSV output has an id,name,quantity,price,
+// category header and numeric categories, so CsvImporter reads it back.
+// Prices are written with TableWriter::number, so they read back exactly.
+
+enum class ExportFormat {
+    Csv,
+    JsonLines
+};
+
+enum class ExportOrder {
+    Stored,   // the order Display All Items uses
+    Category, // Clothing, Electronics, then Entertainment
+    Quantity,
+    Price
+};
+
+class ItemExporter {
+private:
+    TableWriter out;
+    ExportFormat format;
+    size_t written = 0;
+
+    static bool needsCsvQuotes(char c) { return c == ',' || c == '"' || c == '\r' || c == '\n'; }
+
+    void csvField(TextView text) {
+        if (std::find_if(text.begin(), text.end(), needsCsvQuotes) == text.end()) {
+            out.text(text.data(), text.length());
+            return;
+        }
+        out.text("\"");
+        size_t start = 0;
+        for (size_t i = 0; i < text.length(); ++i) {
+            if (text[i] != '"') continue;
+            out.text(text.data() + start, i + 1 - start);
+            out.text("\"");
+            start = i + 1;
+        }
+        out.text(text.data() + start, text.length() - start);
+        out.text("\"");
+    }
+
+    void jsonString(TextView text) {
+        static const char hex[] = "0123456789abcdef";
+        out.text("\"");
+        size_t start = 0;
+        for (size_t i = 0; i < text.length(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out.text(text.data() + start, i - start);
+            start = i + 1;
+            switch (c) {
+                case '"': out.text("\\\""); break;
+                case '\\': out.text("\\\\"); break;
+                case '\n': out.text("\\n"); break;
+                case '\r': out.text("\\r"); break;
+                case '\t': out.text("\\t"); break;
+                default: {
+                    char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+                    out.text(escape, sizeof escape);
+                }
+            }
+        }
+        out.text(text.data() + start, text.length() - start);
+        out.text("\"");
+    }
+
+    template <typename T>
+    void writeIndex(const ItemStore& items, const SortedIndex<T>& index, bool ascending) {
+        if (ascending) {
+            for (typename SortedIndex<T>::const_iterator it = index.begin(); it != index.end(); ++it) {
+                write(*items.get(it->handle));
+            }
+        } else {
+            for (typename SortedIndex<T>::const_reverse_iterator it = index.rbegin(); it != index.rend(); ++it) {
+                write(*items.get(it->handle));
+            }
+        }
+    }
+
+public:
+    ItemExporter(OutputSink& sink, ExportFormat format) : out(sink, 1 << 20), format(format) {
+        if (format == ExportFormat::Csv) out.line("id,name,quantity,price,category");
+    }
+
+    void write(const Item& item) {
+        if (format == ExportFormat::Csv) {
+            csvField(item.getId());
+            out.text(",");
+            csvField(item.getName());
+            out.text(",");
+            out.cell(item.getQuantity(), 0);
+            out.text(",");
+            out.number(item.getPrice());
+            out.text(",");
+            out.cell(static_cast<int>(item.getCategory()), 0);
+        } else {
+            out.text("{\"id\":");
+            jsonString(item.getId());
+            out.text(",\"name\":");
+            jsonString(item.getName());
+            out.text(",\"quantity\":");
+            out.cell(item.getQuantity(), 0);
+            out.text(",\"price\":");
+            out.number(item.getPrice());
+            out.text(",\"category\":\"");
+            out.text(item.getCategoryName());
+            out.text("\"}");
+        }
+        out.endRow();
+        ++written;
+    }
+
+    // Write every item of inventory in the given order
+    void write(const Inventory& inventory, ExportOrder order, bool ascending) {
+        const ItemStore& items = inventory.getItems();
+        switch (order) {
+            case ExportOrder::Stored:
+                for (const Item& item : items) write(item);
+                break;
+            case ExportOrder::Category:
+                for (int category = 1; category <= categoryCount; ++category) {
+                    for (ItemHandle handle : inventory.getCategoryMembers(static_cast<Category>(category))) {
+                        write(*items.get(handle));
+                    }
+                }
+                break;
+            case ExportOrder::Quantity:
+                writeIndex(items, inventory.getQuantityIndex(), ascending);
+                break;
+            case ExportOrder::Price:
+                writeIndex(items, inventory.getPriceIndex(), ascending);
+                break;
+        }
+    }
+
+    void flush() { out.flush(); }
+
+    // Items written so far
+    size_t count() const { return written; }
+};
+
+// Export inventory to an open file descriptor
+inline bool exportItems(const Inventory& inventory, int fd, ExportFormat format, ExportOrder order, bool ascending,
+                        size_t& count, std::string& error) {
+    DescriptorSink sink(fd);
+    ItemExporter exporter(sink, format);
+    exporter.write(inventory, order, ascending);
+    exporter.flush();
+    count = exporter.count();
+    if (!sink.good()) {
+        error = "write failed";
+        return false;
+    }
+    return true;
+}
+
+#endif
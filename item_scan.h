@@ -0,0 +1,202 @@
+#ifndef ITEM_SCAN_H
+#define ITEM_SCAN_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "item.h"
+#include "item_store.h"
+#include "simd_filter.h"
+#include "thread_pool.h"
+
+// Ad-hoc queries that no index answers: any combination of a category, a
+// quantity range, a price range and a name substring. Bounds are inclusive
+// and the name match ignores case.
+struct ItemQuery {
+    int category = 0; // 0 for any
+    int minQuantity = std::numeric_limits<int>::min();
+    int maxQuantity = std::numeric_limits<int>::max();
+    double minPrice = -std::numeric_limits<double>::infinity();
+    double maxPrice = std::numeric_limits<double>::infinity();
+    std::string nameContains;
+
+    bool matches(const Item& item) const {
+        return (category == 0 || static_cast<int>(item.getCategory()) == category) &&
+               item.getQuantity() >= minQuantity && item.getQuantity() <= maxQuantity &&
+               item.getPrice() >= minPrice && item.getPrice() <= maxPrice &&
+               (nameContains.empty() || item.nameContains(nameContains));
+    }
+};
+
+// Count, total quantity and stock value (quantity times price) of the
+// items matching a query
+struct ItemTotals {
+    size_t items = 0;
+    long long quantity = 0;
+    double value = 0;
+};
+
+// Runs ItemQuery filters over an ItemStore on a thread pool.
+//
+// The store is cut into contiguous partitions, a few per thread, and each
+// task filters one partition into its own list of positions. The lists are
+// then copied, in partition order, into one result, so matches come out in
+// store order (the order Display All Items uses) for any thread count.
+// Stores smaller than one partition are scanned on the calling thread.
+//
+// Within a partition, rows are filtered a block at a time on the store's
+// columns: one SIMD kernel per constrained column (see simd_filter.h) makes
+// a selection bitmap, and the bitmaps are ANDed, so unconstrained columns
+// are never read. Matching rows are then taken from the set bits; only they
+// have their Item read, and only when the query has a name condition.
+class ItemScanner {
+private:
+    static const size_t minPartition = 16384;
+    static const size_t partitionsPerThread = 4;
+    static const size_t blockRows = 2048;
+
+    ThreadPool pool;
+
+    size_t partitionSize(size_t items) const {
+        size_t partitions = partitionsPerThread * pool.size();
+        size_t size = (items + partitions - 1) / partitions;
+        return size > minPartition ? size : minPartition;
+    }
+
+    // bits = which of the rows begin .. begin + rows - 1 pass the numeric
+    // conditions; rows <= blockRows
+    static void matchColumns(const ItemStore& items, const ItemQuery& query, size_t begin, size_t rows,
+                             uint64_t* bits) {
+        const FilterKernels& kernels = filterKernels();
+        size_t words = bitmapWords(rows);
+        uint64_t column[blockRows / 64];
+        bool first = true;
+        // The first condition fills bits, later ones are ANDed in
+        auto next = [&]() -> uint64_t* { return first ? bits : column; };
+        auto merge = [&] {
+            if (!first) andBitmap(bits, column, words);
+            first = false;
+        };
+        if (query.category != 0) {
+            kernels.byteEquals(items.categoryColumn() + begin, rows, static_cast<uint8_t>(query.category), next());
+            merge();
+        }
+        if (query.minQuantity != std::numeric_limits<int>::min() ||
+            query.maxQuantity != std::numeric_limits<int>::max()) {
+            kernels.intRange(items.quantityColumn() + begin, rows, query.minQuantity, query.maxQuantity, next());
+            merge();
+        }
+        if (query.minPrice != -std::numeric_limits<double>::infinity() ||
+            query.maxPrice != std::numeric_limits<double>::infinity()) {
+            kernels.doubleRange(items.priceColumn() + begin, rows, query.minPrice, query.maxPrice, next());
+            merge();
+        }
+        if (first) {
+            for (size_t w = 0; w < words; ++w) bits[w] = ~uint64_t(0);
+            if (rows % 64 != 0) bits[words - 1] = (uint64_t(1) << (rows % 64)) - 1;
+        }
+    }
+
+    // Append the positions in [begin, end) that match query
+    static void scan(const ItemStore& items, const ItemQuery& query, size_t begin, size_t end,
+                     std::vector<uint32_t>& matches) {
+        uint64_t bits[blockRows / 64];
+        for (size_t block = begin; block < end; block += blockRows) {
+            size_t rows = end - block < blockRows ? end - block : blockRows;
+            matchColumns(items, query, block, rows, bits);
+            for (size_t w = 0; w < bitmapWords(rows); ++w) {
+                for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                    size_t position = block + 64 * w + lowestBit(word);
+                    if (query.nameContains.empty() || items[position].nameContains(query.nameContains)) {
+                        matches.push_back(static_cast<uint32_t>(position));
+                    }
+                }
+            }
+        }
+    }
+
+    static ItemQuery fold(const ItemQuery& query) {
+        ItemQuery folded = query;
+        folded.nameContains = normalizeItemId(query.nameContains);
+        return folded;
+    }
+
+public:
+    // threads 0 uses every hardware thread
+    explicit ItemScanner(unsigned threads = 0) : pool(threads) {}
+
+    unsigned threadCount() const { return pool.size(); }
+
+    // Positions (ItemStore indexes) of the matching items, ascending. They
+    // stay valid until the store changes.
+    std::vector<uint32_t> find(const ItemStore& items, const ItemQuery& query) {
+        ItemQuery folded = fold(query);
+        size_t partition = partitionSize(items.size());
+        size_t partitions = (items.size() + partition - 1) / partition;
+        std::vector<std::vector<uint32_t>> found(partitions);
+        pool.run(partitions, [&](size_t p) {
+            scan(items, folded, p * partition, std::min(items.size(), (p + 1) * partition), found[p]);
+        });
+        if (partitions == 1) return std::move(found[0]);
+
+        std::vector<size_t> offsets(partitions + 1, 0);
+        for (size_t p = 0; p < partitions; ++p) offsets[p + 1] = offsets[p] + found[p].size();
+        std::vector<uint32_t> result(offsets[partitions]);
+        pool.run(partitions, [&](size_t p) {
+            if (!found[p].empty()) {
+                std::memcpy(result.data() + offsets[p], found[p].data(), found[p].size() * sizeof(uint32_t));
+            }
+        });
+        return result;
+    }
+
+    // Number of matching items, without collecting them
+    size_t count(const ItemStore& items, const ItemQuery& query) {
+        return totals(items, query).items;
+    }
+
+    // Sums over the matching items. Without a name condition these read
+    // only the quantity and price columns.
+    ItemTotals totals(const ItemStore& items, const ItemQuery& query) {
+        ItemQuery folded = fold(query);
+        size_t partition = partitionSize(items.size());
+        size_t partitions = (items.size() + partition - 1) / partition;
+        std::vector<ItemTotals> sums(partitions);
+        pool.run(partitions, [&](size_t p) {
+            const int* quantities = items.quantityColumn();
+            const double* prices = items.priceColumn();
+            size_t end = std::min(items.size(), (p + 1) * partition);
+            uint64_t bits[blockRows / 64];
+            ItemTotals sum;
+            for (size_t block = p * partition; block < end; block += blockRows) {
+                size_t rows = end - block < blockRows ? end - block : blockRows;
+                matchColumns(items, folded, block, rows, bits);
+                for (size_t w = 0; w < bitmapWords(rows); ++w) {
+                    for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                        size_t position = block + 64 * w + lowestBit(word);
+                        if (!folded.nameContains.empty() && !items[position].nameContains(folded.nameContains)) {
+                            continue;
+                        }
+                        ++sum.items;
+                        sum.quantity += quantities[position];
+                        sum.value += quantities[position] * prices[position];
+                    }
+                }
+            }
+            sums[p] = sum;
+        });
+        ItemTotals total;
+        for (const ItemTotals& sum : sums) {
+            total.items += sum.items;
+            total.quantity += sum.quantity;
+            total.value += sum.value;
+        }
+        return total;
+    }
+};
+
+#endif
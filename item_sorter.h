@@ -0,0 +1,123 @@
+#ifndef ITEM_SORTER_H
+#define ITEM_SORTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "item_store.h"
+
+enum class SortField { Quantity, Price, Category };
+
+struct SortKey {
+    SortField field;
+    bool ascending;
+};
+
+// Computes item orderings for the inventory.
+//
+// Each sort key is reduced to an unsigned 64-bit value whose natural order is
+// the requested order, paired with the item's position, and the pairs are
+// sorted: introsort (std::sort) for small inputs, LSD radix sort otherwise.
+// Multi-key orderings apply the keys from least to most significant, and
+// every pass keeps ties in their current relative order, so all sorts are
+// stable. Buffers are kept between calls, so repeated sorts of a similarly
+// sized inventory do not allocate.
+class ItemSorter {
+private:
+    typedef std::pair<uint64_t, uint32_t> KeyedIndex;
+
+    static const size_t radixThreshold = 256;
+
+    std::vector<KeyedIndex> pairs;
+    std::vector<KeyedIndex> scratch;
+    std::vector<uint32_t> result;
+
+    // Reads only the key's column of the store
+    static uint64_t encode(const ItemStore& store, uint32_t position, SortField field) {
+        switch (field) {
+            case SortField::Quantity:
+                // flip the sign bit so negative values order before positive ones
+                return static_cast<uint32_t>(store.quantityColumn()[position]) ^ 0x80000000u;
+            case SortField::Price: {
+                double price = store.priceColumn()[position];
+                uint64_t bits;
+                std::memcpy(&bits, &price, sizeof bits);
+                return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+            }
+            case SortField::Category:
+                return store.categoryColumn()[position];
+        }
+        return 0;
+    }
+
+    // Stable LSD radix sort on the 64-bit keys, one byte per pass; passes where
+    // every key has the same byte are skipped.
+    void radixSort() {
+        size_t n = pairs.size();
+        scratch.resize(n);
+        size_t counts[8][256] = {};
+        for (const KeyedIndex& p : pairs) {
+            for (int b = 0; b < 8; ++b) {
+                ++counts[b][(p.first >> (8 * b)) & 0xFF];
+            }
+        }
+        for (int b = 0; b < 8; ++b) {
+            size_t* count = counts[b];
+            if (count[(pairs[0].first >> (8 * b)) & 0xFF] == n) continue;
+            size_t offset = 0;
+            for (int d = 0; d < 256; ++d) {
+                size_t c = count[d];
+                count[d] = offset;
+                offset += c;
+            }
+            for (const KeyedIndex& p : pairs) {
+                scratch[count[(p.first >> (8 * b)) & 0xFF]++] = p;
+            }
+            pairs.swap(scratch);
+        }
+    }
+
+public:
+    // Order of the store's items under the given keys, most significant key
+    // first. The result lists positions (dense indices) and stays valid until
+    // the next call.
+    const std::vector<uint32_t>& order(const ItemStore& store, const SortKey* keys, size_t keyCount) {
+        size_t n = store.size();
+        result.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            result[i] = static_cast<uint32_t>(i);
+        }
+
+        for (size_t k = keyCount; k-- > 0;) {
+            const SortKey& key = keys[k];
+            pairs.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t value = encode(store, result[i], key.field);
+                pairs[i] = KeyedIndex(key.ascending ? value : ~value, result[i]);
+            }
+
+            if (n < radixThreshold) {
+                // Ties fall back to the current rank, which keeps the sort stable
+                scratch.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    scratch[i] = KeyedIndex(pairs[i].first, static_cast<uint32_t>(i));
+                }
+                std::sort(scratch.begin(), scratch.begin() + n);
+                for (size_t i = 0; i < n; ++i) {
+                    result[i] = pairs[scratch[i].second].second;
+                }
+            } else {
+                radixSort();
+                for (size_t i = 0; i < n; ++i) {
+                    result[i] = pairs[i].second;
+                }
+            }
+        }
+        return result;
+    }
+};
+
+#endif
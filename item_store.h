@@ -0,0 +1,286 @@
+#ifndef ITEM_STORE_H
+#define ITEM_STORE_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "item.h"
+#include "string_arena.h"
+
+// Stable reference to an item in an ItemStore. A handle keeps pointing at the
+// same item while other items are added or removed; once its item is removed
+// the handle goes stale and lookups through it fail.
+struct ItemHandle {
+    uint32_t slot;
+    uint32_t generation;
+
+    bool operator==(const ItemHandle& other) const {
+        return slot == other.slot && generation == other.generation;
+    }
+    bool operator!=(const ItemHandle& other) const { return !(*this == other); }
+};
+
+// Memory held by an ItemStore
+struct ItemStoreStats {
+    size_t items = 0;
+    size_t slots = 0;          // handle slots, including free ones
+    size_t freeSlots = 0;      // reused by the next adds
+    size_t recordBytes = 0;    // item, column and slot arrays, including spare capacity
+    size_t textBytes = 0;      // StringArena blocks of the stored items
+    size_t pooledBlocks = 0;   // text blocks of removed items kept for reuse
+    size_t pooledBytes = 0;
+    uint64_t reusedBlocks = 0; // adds that took a pooled block instead of new arena space
+};
+
+// Growable, contiguous storage for Item records.
+//
+// Items are stored by value in one dense array, so scans walk memory linearly
+// and adding an item is amortized O(1). Removal moves the last item into the
+// freed position to keep the array dense. Handles go through a slot table
+// (slot -> dense index) so they survive those moves.
+//
+// Quantity, price and category are also kept column by column, in dense
+// arrays in the same order as the items. Filters, sums and sort keys read
+// just the columns they need (4, 8 or 1 bytes per item instead of a whole
+// Item), in loops the compiler can vectorize. Items are therefore only
+// handed out const, and quantities and prices change through setQuantity
+// and setPrice, which keep the columns in step.
+//
+// The store is a pool: freed slots are reused first, and so is the text of
+// removed items. A removed item's text block goes on a free list for its
+// block size, and the next item added with text of that size moves its
+// text into it, so a stream of adds and removes keeps reusing the same
+// arena space instead of spreading live text over ever more chunks. At
+// most a quarter as many blocks as there are items are kept (at least 64),
+// so a shrinking store lets its chunks go; clear() and the destructor give
+// back the rest.
+class ItemStore {
+private:
+    static const uint32_t npos = 0xFFFFFFFFu;
+    // Text blocks up to this size are pooled
+    static const size_t pooledBlockLimit = 256;
+    static const size_t minPooledBlocks = 64;
+
+    struct Slot {
+        uint32_t dense;      // dense index while in use, next free slot otherwise
+        uint32_t generation; // bumped on every removal to invalidate old handles
+    };
+
+    std::vector<Item> items;
+    std::vector<int> quantities;
+    std::vector<double> prices;
+    std::vector<uint8_t> categories;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<Slot> slots;
+    uint32_t freeSlot = npos;
+    size_t freeSlots = 0;
+
+    // Text blocks of removed items, indexed by block size / 8
+    std::vector<char*> pool[pooledBlockLimit / 8 + 1];
+    size_t pooledBlocks = 0;
+    size_t pooledBytes = 0;
+    uint64_t reusedBlocks = 0;
+
+    size_t poolCapacity() const {
+        return items.size() / 4 > minPooledBlocks ? items.size() / 4 : minPooledBlocks;
+    }
+
+    // Give the item's text to the pool if there is room; otherwise it is
+    // released with the item
+    void poolText(Item& item) {
+        size_t size = StringArena::blockSize(item.textBytes());
+        if (size == 0 || size > pooledBlockLimit || pooledBlocks >= poolCapacity()) return;
+        pool[size / 8].push_back(item.detachText());
+        ++pooledBlocks;
+        pooledBytes += size;
+    }
+
+    // Move the item's text into a pooled block of its size, if there is one
+    void reuseText(Item& item) {
+        size_t size = StringArena::blockSize(item.textBytes());
+        if (size == 0 || size > pooledBlockLimit || pool[size / 8].empty()) return;
+        item.moveTextTo(pool[size / 8].back());
+        pool[size / 8].pop_back();
+        --pooledBlocks;
+        pooledBytes -= size;
+        ++reusedBlocks;
+    }
+
+    // Release pooled blocks, largest first, until at most keep are left
+    void trimPool(size_t keep) {
+        for (size_t c = pooledBlockLimit / 8; pooledBlocks > keep; --c) {
+            while (!pool[c].empty() && pooledBlocks > keep) {
+                StringArena::release(pool[c].back(), c * 8);
+                pool[c].pop_back();
+                --pooledBlocks;
+                pooledBytes -= c * 8;
+            }
+        }
+    }
+
+public:
+    ItemStore() = default;
+    ~ItemStore() { trimPool(0); }
+
+    ItemStore(const ItemStore&) = delete;
+    ItemStore& operator=(const ItemStore&) = delete;
+
+    // Add an item and return its handle
+    ItemHandle add(Item item) {
+        reuseText(item);
+        uint32_t slot;
+        if (freeSlot != npos) {
+            slot = freeSlot;
+            freeSlot = slots[slot].dense;
+            --freeSlots;
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{0, 0});
+        }
+        slots[slot].dense = static_cast<uint32_t>(items.size());
+        quantities.push_back(item.getQuantity());
+        prices.push_back(item.getPrice());
+        categories.push_back(static_cast<uint8_t>(item.getCategory()));
+        items.push_back(std::move(item));
+        denseToSlot.push_back(slot);
+        return ItemHandle{slot, slots[slot].generation};
+    }
+
+    // Remove the item behind the handle; the last item takes its place
+    bool remove(ItemHandle handle) {
+        if (!contains(handle)) return false;
+        uint32_t dense = slots[handle.slot].dense;
+        uint32_t last = static_cast<uint32_t>(items.size() - 1);
+        poolText(items[dense]);
+        if (dense != last) {
+            items[dense] = std::move(items[last]);
+            quantities[dense] = quantities[last];
+            prices[dense] = prices[last];
+            categories[dense] = categories[last];
+            denseToSlot[dense] = denseToSlot[last];
+            slots[denseToSlot[dense]].dense = dense;
+        }
+        items.pop_back();
+        quantities.pop_back();
+        prices.pop_back();
+        categories.pop_back();
+        denseToSlot.pop_back();
+
+        Slot& freed = slots[handle.slot];
+        ++freed.generation;
+        freed.dense = freeSlot;
+        freeSlot = handle.slot;
+        ++freeSlots;
+        trimPool(poolCapacity());
+        return true;
+    }
+
+    bool contains(ItemHandle handle) const {
+        return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation &&
+               slots[handle.slot].dense < items.size() && denseToSlot[slots[handle.slot].dense] == handle.slot;
+    }
+
+    const Item* get(ItemHandle handle) const {
+        return contains(handle) ? &items[slots[handle.slot].dense] : nullptr;
+    }
+
+    // Change an item's quantity or price, keeping its column in step
+    const Item& setQuantity(ItemHandle handle, int quantity) {
+        uint32_t dense = slots[handle.slot].dense;
+        items[dense].setQuantity(quantity);
+        quantities[dense] = quantity;
+        return items[dense];
+    }
+
+    const Item& setPrice(ItemHandle handle, double price) {
+        uint32_t dense = slots[handle.slot].dense;
+        items[dense].setPrice(price);
+        prices[dense] = price;
+        return items[dense];
+    }
+
+    // Columns, indexed by position like operator[]; valid until the store
+    // changes
+    const int* quantityColumn() const { return quantities.data(); }
+    const double* priceColumn() const { return prices.data(); }
+    const uint8_t* categoryColumn() const { return categories.data(); }
+
+    // Dense (positional) access, 0 <= index < size()
+    const Item& operator[](size_t index) const { return items[index]; }
+
+    ItemHandle handleAt(size_t index) const {
+        uint32_t slot = denseToSlot[index];
+        return ItemHandle{slot, slots[slot].generation};
+    }
+
+    size_t indexOf(ItemHandle handle) const { return slots[handle.slot].dense; }
+
+    // Exchange the positions of two items; their handles stay valid
+    void swap(size_t a, size_t b) {
+        if (a == b) return;
+        std::swap(items[a], items[b]);
+        std::swap(quantities[a], quantities[b]);
+        std::swap(prices[a], prices[b]);
+        std::swap(categories[a], categories[b]);
+        std::swap(denseToSlot[a], denseToSlot[b]);
+        slots[denseToSlot[a]].dense = static_cast<uint32_t>(a);
+        slots[denseToSlot[b]].dense = static_cast<uint32_t>(b);
+    }
+
+    // Remove every item and release the pooled text; outstanding handles go
+    // stale
+    void clear() {
+        trimPool(0);
+        items.clear();
+        quantities.clear();
+        prices.clear();
+        categories.clear();
+        denseToSlot.clear();
+        slots.clear();
+        freeSlot = npos;
+        freeSlots = 0;
+    }
+
+    void reserve(size_t count) {
+        items.reserve(count);
+        quantities.reserve(count);
+        prices.reserve(count);
+        categories.reserve(count);
+        denseToSlot.reserve(count);
+        slots.reserve(count);
+    }
+
+    size_t size() const { return items.size(); }
+    size_t capacity() const { return items.capacity(); }
+    bool empty() const { return items.empty(); }
+
+    std::vector<Item>::const_iterator begin() const { return items.begin(); }
+    std::vector<Item>::const_iterator end() const { return items.end(); }
+
+    ItemStoreStats stats() const {
+        ItemStoreStats result;
+        result.items = items.size();
+        result.slots = slots.size();
+        result.freeSlots = freeSlots;
+        result.recordBytes = items.capacity() * sizeof(Item) + quantities.capacity() * sizeof(int) +
+                             prices.capacity() * sizeof(double) + categories.capacity() +
+                             denseToSlot.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(Slot);
+        for (const Item& item : items) {
+            result.textBytes += StringArena::blockSize(item.textBytes());
+        }
+        result.pooledBlocks = pooledBlocks;
+        result.pooledBytes = pooledBytes;
+        result.reusedBlocks = reusedBlocks;
+        return result;
+    }
+
+    // Total bytes owned by the store: record arrays, the items' text and the
+    // pooled text (not counting the unused ends of arena chunks)
+    size_t memoryUsage() const {
+        ItemStoreStats usage = stats();
+        return usage.recordBytes + usage.textBytes + usage.pooledBytes;
+    }
+};
+
+#endif
@@ -0,0 +1,405 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "file_io.h"
+#include "inventory.h"
+#include "item.h"
+#include "snapshot.h"
+
+// Write-ahead journal of inventory changes.
+//
+// File layout: the 8-byte journalMagic, then records of
+//   uint32_t payload length, uint32_t CRC-32 of the payload, payload
+// where the payload is a JournalOp byte followed by its fields. Strings are
+// a uint32_t length and the bytes; numbers are in native byte order.
+//
+// Records hold absolute values (a quantity change records the new quantity),
+// and replay skips adds of IDs that already exist. Replaying a journal over
+// a snapshot that already contains some of its changes therefore still ends
+// in the journal's final state, which keeps compaction crash-safe: the
+// snapshot is written, synced and renamed into place (and its directory
+// synced) first, and the journal emptied afterwards.
+//
+// Changes are encoded into memory as they happen and written with a single
+// write and fsync per group (group commit). A group is committed once it
+// holds groupRecords records, when a change arrives more than groupDelay
+// after the group started, or when commit() is called. Changes in an
+// uncommitted group are lost if the process dies. A group whose write or
+// fsync fails stays pending, and the file is cut back to its committed
+// length so the retry does not land after a torn record; if that fails
+// too, the journal closes and every later commit fails.
+//
+// The file is never rewritten in place: a new journal (or the intact part
+// of a damaged one) is written to a temporary file, synced and renamed over
+// the old one. A file that is empty or holds only part of journalMagic was
+// cut short while being created and counts as an empty journal.
+
+const char journalMagic[8] = {'I', 'N', 'V', 'W', 'A', 'L', '1', '\0'};
+
+enum class JournalOp : uint8_t {
+    Add = 1,
+    SetQuantity = 2,
+    SetPrice = 3,
+    Remove = 4,
+    Clear = 5
+};
+
+inline uint32_t crc32(const char* data, size_t size) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+        return entries;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+class Journal: public InventoryObserver {
+private:
+    FILE* file = nullptr;
+    std::string path;
+    std::vector<char> pending;
+    size_t pendingRecords = 0;
+    size_t recordStart = 0;
+    std::chrono::steady_clock::time_point groupStart;
+    size_t groupRecords = 1024;
+    std::chrono::microseconds groupDelay{10000};
+    uint64_t committedBytes = 0;
+    uint64_t compactBytes = 64ull << 20;
+    std::string lastError;
+
+    void put(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        pending.insert(pending.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void putValue(T value) { put(&value, sizeof value); }
+
+    void putString(TextView text) {
+        putValue(static_cast<uint32_t>(text.length()));
+        put(text.data(), text.length());
+    }
+
+    void beginRecord(JournalOp op) {
+        recordStart = pending.size();
+        pending.resize(pending.size() + 2 * sizeof(uint32_t));
+        putValue(static_cast<uint8_t>(op));
+    }
+
+    void endRecord() {
+        const char* payload = pending.data() + recordStart + 2 * sizeof(uint32_t);
+        uint32_t length = static_cast<uint32_t>(pending.size() - recordStart - 2 * sizeof(uint32_t));
+        uint32_t crc = crc32(payload, length);
+        std::memcpy(&pending[recordStart], &length, sizeof length);
+        std::memcpy(&pending[recordStart + sizeof length], &crc, sizeof crc);
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (pendingRecords++ == 0) groupStart = now;
+        if (pendingRecords >= groupRecords || now - groupStart >= groupDelay) commit();
+    }
+
+    // Reads fields out of a record payload
+    class Reader {
+    private:
+        const char* data;
+        size_t size;
+        size_t position = 0;
+
+    public:
+        Reader(const char* data, size_t size) : data(data), size(size) {}
+
+        template <typename T>
+        bool value(T& out) {
+            if (size - position < sizeof out) return false;
+            std::memcpy(&out, data + position, sizeof out);
+            position += sizeof out;
+            return true;
+        }
+
+        bool text(std::string& out) {
+            uint32_t length;
+            if (!value(length) || size - position < length) return false;
+            out.assign(data + position, length);
+            position += length;
+            return true;
+        }
+
+        bool done() const { return position == size; }
+    };
+
+    // Whether size bytes could be the start of a journal whose creation was
+    // cut short
+    static bool isMagicPrefix(const char* data, size_t size) {
+        return size < sizeof journalMagic && (size == 0 || std::memcmp(data, journalMagic, size) == 0);
+    }
+
+    // Replace the file at journalPath with size bytes of data, durably
+    static bool writeJournalFile(const std::string& journalPath, const char* data, size_t size) {
+        std::string temporary = journalPath + ".tmp";
+        FILE* out = fopen(temporary.c_str(), "wb");
+        bool written = out != nullptr && writeBytes(out, data, size) && syncFile(out);
+        if (out != nullptr) written = fclose(out) == 0 && written;
+        if (!written || !replaceFile(temporary, journalPath)) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return syncDirectory(journalPath);
+    }
+
+    static bool apply(Inventory& inventory, const char* payload, size_t length) {
+        Reader reader(payload, length);
+        uint8_t op;
+        std::string id;
+        if (!reader.value(op)) return false;
+        switch (static_cast<JournalOp>(op)) {
+            case JournalOp::Add: {
+                std::string name;
+                int32_t quantity;
+                double price;
+                uint8_t category;
+                if (!reader.text(id) || !reader.text(name) || !reader.value(quantity) || !reader.value(price) ||
+                    !reader.value(category) || !reader.done() || category < 1 || category > categoryCount) {
+                    return false;
+                }
+                inventory.insertItem(Item(id, name, quantity, price, static_cast<Category>(category)));
+                return true;
+            }
+            case JournalOp::SetQuantity: {
+                int32_t quantity;
+                if (!reader.text(id) || !reader.value(quantity) || !reader.done()) return false;
+                inventory.setQuantity(id, quantity);
+                return true;
+            }
+            case JournalOp::SetPrice: {
+                double price;
+                if (!reader.text(id) || !reader.value(price) || !reader.done()) return false;
+                inventory.setPrice(id, price);
+                return true;
+            }
+            case JournalOp::Remove:
+                if (!reader.text(id) || !reader.done()) return false;
+                inventory.eraseItem(id);
+                return true;
+            case JournalOp::Clear:
+                if (!reader.done()) return false;
+                inventory.clear();
+                return true;
+        }
+        return false;
+    }
+
+public:
+    Journal() = default;
+    ~Journal() { close(); }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Group commit limits: at most records changes, or delay, per fsync
+    void setGroupCommit(size_t records, std::chrono::microseconds delay) {
+        groupRecords = records > 0 ? records : 1;
+        groupDelay = delay;
+    }
+
+    // Journal size past which needsCompaction() asks for a new snapshot
+    void setCompactionThreshold(uint64_t bytes) { compactBytes = bytes; }
+
+    // Apply the records of the journal at journalPath to inventory. A torn or
+    // damaged record ends the journal: it and everything after it are cut off
+    // the file. Call this before attaching the journal to the inventory.
+    bool replay(Inventory& inventory, const std::string& journalPath, size_t& applied, std::string& error) {
+        applied = 0;
+        FILE* in = fopen(journalPath.c_str(), "rb");
+        if (in == nullptr) return true; // nothing journaled yet
+
+        uint64_t size = 0;
+        std::vector<char> bytes;
+        bool ok = fileSize(in, size) && seekFile(in, 0);
+        if (ok) {
+            bytes.resize(static_cast<size_t>(size));
+            ok = readBytes(in, bytes.data(), bytes.size());
+        }
+        fclose(in);
+        if (!ok) {
+            error = "cannot read " + journalPath;
+            return false;
+        }
+        if (isMagicPrefix(bytes.data(), bytes.size())) return true; // open() starts it afresh
+        if (bytes.size() < sizeof journalMagic || std::memcmp(bytes.data(), journalMagic, sizeof journalMagic) != 0) {
+            error = journalPath + " is not an inventory journal";
+            return false;
+        }
+
+        size_t position = sizeof journalMagic;
+        while (bytes.size() - position >= 2 * sizeof(uint32_t)) {
+            uint32_t length, crc;
+            std::memcpy(&length, &bytes[position], sizeof length);
+            std::memcpy(&crc, &bytes[position + sizeof length], sizeof crc);
+            const char* payload = bytes.data() + position + 2 * sizeof(uint32_t);
+            if (bytes.size() - position - 2 * sizeof(uint32_t) < length || crc32(payload, length) != crc ||
+                !apply(inventory, payload, length)) {
+                break;
+            }
+            position += 2 * sizeof(uint32_t) + length;
+            ++applied;
+        }
+
+        if (position != bytes.size()) {
+            // Keep only the intact prefix
+            if (!writeJournalFile(journalPath, bytes.data(), position)) {
+                error = "cannot repair " + journalPath;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Open the journal for appending. A journal that is missing, or shorter
+    // than journalMagic (replay() has checked it is a prefix), is created
+    // afresh.
+    bool open(const std::string& journalPath, std::string& error) {
+        close();
+        path = journalPath;
+        uint64_t size = 0;
+        FILE* existing = fopen(journalPath.c_str(), "rb");
+        bool sized = existing == nullptr || fileSize(existing, size);
+        if (existing != nullptr) fclose(existing);
+        if (!sized || (size < sizeof journalMagic && !writeJournalFile(journalPath, journalMagic, sizeof journalMagic))) {
+            error = "cannot write " + journalPath;
+            return false;
+        }
+        file = fopen(journalPath.c_str(), "ab");
+        if (file == nullptr) {
+            error = "cannot open " + journalPath;
+            return false;
+        }
+        committedBytes = size < sizeof journalMagic ? sizeof journalMagic : size;
+        return true;
+    }
+
+    // Write and fsync every pending change
+    bool commit() {
+        if (file == nullptr || pendingRecords == 0) return file != nullptr || pendingRecords == 0;
+        bool ok = writeBytes(file, pending.data(), pending.size()) && syncFile(file);
+        if (!ok) {
+            lastError = "cannot write " + path;
+            fclose(file);
+            file = truncateFile(path, committedBytes) ? fopen(path.c_str(), "ab") : nullptr;
+            if (file == nullptr) lastError += "; journal closed";
+            return false;
+        }
+        committedBytes += pending.size();
+        pending.clear();
+        pendingRecords = 0;
+        return true;
+    }
+
+    // Empty the journal once its changes are in a snapshot. If the empty
+    // journal cannot be put in place the old one stays, which replays to
+    // the same state over the snapshot.
+    bool reset(std::string& error) {
+        pending.clear();
+        pendingRecords = 0;
+        if (file != nullptr) fclose(file);
+        bool replaced = writeJournalFile(path, journalMagic, sizeof journalMagic);
+        if (replaced) committedBytes = sizeof journalMagic;
+        file = fopen(path.c_str(), "ab");
+        if (!replaced || file == nullptr) {
+            error = "cannot reset " + path;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (file == nullptr) return;
+        commit();
+        fclose(file);
+        file = nullptr;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Bytes in the journal, including changes not yet committed
+    uint64_t size() const { return committedBytes + pending.size(); }
+
+    bool needsCompaction() const { return size() > compactBytes; }
+
+    // Message for the last failed background commit, empty when none
+    const std::string& error() const { return lastError; }
+
+    void itemAdded(const Item& item) override {
+        beginRecord(JournalOp::Add);
+        putString(item.getId());
+        putString(item.getName());
+        putValue(static_cast<int32_t>(item.getQuantity()));
+        putValue(item.getPrice());
+        putValue(static_cast<uint8_t>(item.getCategory()));
+        endRecord();
+    }
+
+    void quantityChanged(const Item& item) override {
+        beginRecord(JournalOp::SetQuantity);
+        putString(item.getId());
+        putValue(static_cast<int32_t>(item.getQuantity()));
+        endRecord();
+    }
+
+    void priceChanged(const Item& item) override {
+        beginRecord(JournalOp::SetPrice);
+        putString(item.getId());
+        putValue(item.getPrice());
+        endRecord();
+    }
+
+    void itemRemoved(const Item& item) override {
+        beginRecord(JournalOp::Remove);
+        putString(item.getId());
+        endRecord();
+    }
+
+    void inventoryCleared() override {
+        beginRecord(JournalOp::Clear);
+        endRecord();
+    }
+};
+
+// Restore an inventory kept at dataPath (dataPath.snap plus dataPath.wal)
+// and journal every further change to it
+inline bool openJournaledInventory(Inventory& inventory, const std::string& dataPath, Journal& journal,
+                                   std::string& error) {
+    std::string snapshotPath = dataPath + ".snap";
+    std::string journalPath = dataPath + ".wal";
+    size_t replayed = 0;
+    if (fileExists(snapshotPath) && !loadSnapshot(inventory, snapshotPath, error)) return false;
+    if (!journal.replay(inventory, journalPath, replayed, error) || !journal.open(journalPath, error)) return false;
+    inventory.setObserver(&journal);
+    return true;
+}
+
+// Write a fresh snapshot to dataPath.snap and empty the journal
+inline bool compactJournal(const Inventory& inventory, const std::string& dataPath, Journal& journal,
+                           std::string& error) {
+    if (!journal.commit()) {
+        error = journal.error();
+        return false;
+    }
+    return saveSnapshot(inventory, dataPath + ".snap", error) && journal.reset(error);
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef LOW_STOCK_INDEX_H
+#define LOW_STOCK_INDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "item.h"
+#include "item_store.h"
+#include "simd_filter.h"
+
+// Set of items whose quantity is at or below the low-stock threshold.
+//
+// The threshold is kept per category (all categories start at 5). The
+// inventory re-evaluates an item whenever it is added or its quantity
+// changes, so the report only walks the items that are actually low.
+// Membership is a dense handle list with swap-with-last removal, like
+// CategoryIndex.
+class LowStockIndex {
+public:
+    // Called when an item enters (low == true) or leaves the low-stock set.
+    // Removing an item from the inventory does not call it.
+    typedef std::function<void(const Item& item, bool low)> Hook;
+
+    static const int defaultThreshold = 5;
+
+private:
+    int thresholds[categoryCount];
+    std::vector<ItemHandle> lowItems;
+    std::vector<uint32_t> positions; // item slot -> position + 1, 0 when not low
+    Hook hook;
+
+    void add(ItemHandle handle) {
+        if (handle.slot >= positions.size()) {
+            positions.resize(handle.slot + 1);
+        }
+        lowItems.push_back(handle);
+        positions[handle.slot] = static_cast<uint32_t>(lowItems.size());
+    }
+
+public:
+    LowStockIndex() {
+        for (int& threshold : thresholds) threshold = defaultThreshold;
+    }
+
+    int threshold(Category category) const { return thresholds[static_cast<int>(category) - 1]; }
+
+    // Thresholds only take effect for existing items after refresh()
+    void setThreshold(Category category, int threshold) { thresholds[static_cast<int>(category) - 1] = threshold; }
+
+    void setThreshold(int threshold) {
+        for (int& t : thresholds) t = threshold;
+    }
+
+    void setHook(Hook newHook) { hook = std::move(newHook); }
+
+    bool isLow(const Item& item) const { return item.getQuantity() <= threshold(item.getCategory()); }
+
+    bool contains(ItemHandle handle) const {
+        return handle.slot < positions.size() && positions[handle.slot] != 0;
+    }
+
+    // Re-evaluate an item after it was added or its quantity changed
+    void update(ItemHandle handle, const Item& item) {
+        bool low = isLow(item);
+        if (low == contains(handle)) return;
+        if (low) {
+            add(handle);
+        } else {
+            erase(handle);
+        }
+        if (hook) hook(item, low);
+    }
+
+    // Forget an item that is being removed
+    void erase(ItemHandle handle) {
+        if (!contains(handle)) return;
+        uint32_t position = positions[handle.slot] - 1;
+        lowItems[position] = lowItems.back();
+        positions[lowItems[position].slot] = position + 1;
+        lowItems.pop_back();
+        positions[handle.slot] = 0;
+    }
+
+    // Forget every item; thresholds and the hook are kept
+    void clear() {
+        lowItems.clear();
+        positions.clear();
+    }
+
+    // Re-evaluate every item, e.g. after a threshold change. The threshold
+    // tests run as SIMD filters over the store's columns; only items that
+    // are low, or were, are then looked at one by one.
+    void refresh(const ItemStore& store) {
+        size_t rows = store.size();
+        size_t words = bitmapWords(rows);
+        std::vector<uint64_t> low(words, 0);
+        std::vector<uint64_t> inCategory(words);
+        std::vector<uint64_t> belowThreshold(words);
+        const FilterKernels& kernels = filterKernels();
+        for (int c = 0; c < categoryCount; ++c) {
+            kernels.byteEquals(store.categoryColumn(), rows, static_cast<uint8_t>(c + 1), inCategory.data());
+            kernels.intRange(store.quantityColumn(), rows, std::numeric_limits<int>::min(), thresholds[c],
+                             belowThreshold.data());
+            for (size_t w = 0; w < words; ++w) low[w] |= inCategory[w] & belowThreshold[w];
+        }
+
+        // update() changes lowItems, so walk a copy
+        std::vector<ItemHandle> previous = lowItems;
+        for (ItemHandle handle : previous) {
+            size_t position = store.indexOf(handle);
+            if (!(low[position / 64] >> (position % 64) & 1)) update(handle, store[position]);
+        }
+        for (size_t w = 0; w < words; ++w) {
+            for (uint64_t word = low[w]; word != 0; word &= word - 1) {
+                size_t position = 64 * w + lowestBit(word);
+                ItemHandle handle = store.handleAt(position);
+                if (!contains(handle)) update(handle, store[position]);
+            }
+        }
+    }
+
+    const std::vector<ItemHandle>& members() const { return lowItems; }
+};
+
+#endif
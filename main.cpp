@@ -3,299 +3,24 @@
 #include <cstdlib>
 #include <iomanip>
 #include <limits>
-using namespace std;
-
-class Item {
-private:
-    // Encapsulation: Private attributes, encapsulating the internal state of the item.
-    string id;
-    string name;
-    int quantity;
-    double price;
-    string category;
-
-public:
-    // Constructor to initialize item
-    Item(string id, string name, int quantity, double price, string category)
-            : id(id), name(name), quantity(quantity), price(price), category(category) {}
-
-    // Getter methods
-    string getId() const { return id; }
-    string getName() const { return name; }
-    int getQuantity() const { return quantity; }
-    double getPrice() const { return price; }
-    string getCategory() const { return category; }
-
-    // Encapsulation
-    // Setter methods
-    void setQuantity(int newQuantity) { quantity = newQuantity; }
-    void setPrice(double newPrice) { price = newPrice; }
-
-    // Abstraction
-    // public method to display the items
-    void displayItem() const {
-        cout << left << setw(10) << id << setw(20) << name << setw(10) << quantity << setw(10) << price << setw(15) << category << endl;
-    }
-};
-
-
-class InventoryBase {
-protected:
-    Item* items[100] = {};
-    int itemCount = 0;
-
-public:
-    ~InventoryBase() {
-        for (int i = 0; i < itemCount; ++i) {
-            delete items[i];
-        }
-    }
-
-    int getItemCount() const { return itemCount; }
-
-    bool isValidCategory(int category) const {
-        return category >= 1 && category <= 3;
-    }
-
-    string categoryToString(int category) const {
-        switch (category) {
-            case 1: return "Clothing";
-            case 2: return "Electronics";
-            case 3: return "Entertainment";
-            default: return "";
-        }
-    }
-
-    // virtual functions
-    virtual void addItem(string id, string name, int quantity, double price, int category) = 0;
-
-    virtual void updateItem(string id) = 0;
-
-    virtual void removeItem(string id) = 0;
-
-    virtual void displayItemsByCategory(int category) = 0;
-
-    virtual void displayAllItems() = 0;
-
-    virtual void searchItem(string id) = 0;
-
-    virtual void sortItems(bool byQuantity, bool ascending) = 0;
-
-    bool isEmpty() const {
-        return itemCount == 0;
-    }
-
-    virtual void displayLowStockItems() = 0;
-};
-
-class Inventory: public InventoryBase {
-private:
-
-public:
-
-    // Add new item to inventory
-    void addItem(string id, string name, int quantity, double price, int category) override {
-        if (!isValidCategory(category)) {
-            cout << "Category does not exist!" << endl;
-            return;
-        }
-
-        if (itemCount < 100) {
-            items[itemCount++] = new Item(id, name, quantity, price, categoryToString(category));
-            cout << "Item added successfully!" << endl;
-        } else {
-            cout << "Inventory is full!" << endl;
-        }
-    }
-
-    // Update item quantity or price
-    void updateItem(string id) override  {
-        // convert id to lowercase
-        string lowercaseId = id;
-        for (size_t i = 0; i < id.length(); ++i) {
-            lowercaseId[i] = tolower(id[i]);
-        }
-        for (int i = 0; i < itemCount; ++i) {
-            auto lowercaseItemId = items[i]->getId();
-            for (size_t i = 0; i < lowercaseItemId.length(); ++i) {
-                lowercaseItemId[i] = tolower(lowercaseItemId[i]);
-            }
-            if (lowercaseId == lowercaseItemId) {
-                int choice;
-                while (true) {
-                    cout << "\n[1] Update Quantity\n[2] Update Price\nEnter choice: ";
-                    cin >> choice;
-
-                    if (cin.fail() || (choice != 1 && choice != 2)) {
-                        cin.clear();
-                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        cout << "Invalid choice! Please enter 1 or 2." << endl;
-                    } else {
-                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        break;
-                    }
-                }
-
-                if (choice == 1) {
-                    int newQuantity;
-                    while (true) {
-                        cout << "Enter new quantity: ";
-                        cin >> newQuantity;
-
-                        if (cin.fail() || newQuantity <= 0) {
-                            cin.clear();
-                            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                            cout << "Invalid input. Please enter a positive integer." << endl;
-                        } else {
-                            cout << "Quantity of Item " << items[i]->getName() << " is updated from " << items[i]->getQuantity() << " to " << newQuantity << endl;
-                            items[i]->setQuantity(newQuantity);
-                            break;
-                        }
-                    }
-                } else if (choice == 2) {
-                    double newPrice;
-                    while (true) {
-                        cout << "Enter new price: ";
-                        cin >> newPrice;
-
-                        if (cin.fail() || newPrice <= 0) {
-                            cin.clear();
-                            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                            cout << "Invalid input. Please enter a positive number." << endl;
-                        } else {
-                            cout << "Price of Item " << items[i]->getName() << " is updated from " << items[i]->getPrice() << " to " << newPrice << endl;
-                            items[i]->setPrice(newPrice);
-                            break;
-                        }
-                    }
-                }
-                return;
-            }
-        }
-        cout << "Item not found!" << endl;
-    }
-
-    // Remove item from inventory
-    void removeItem(string id) override {
-        for (int i = 0; i < itemCount; ++i) {
-            if (items[i]->getId() == id) {
-                cout << "Item " << items[i]->getName() << " has been removed from the inventory." << endl;
-                delete items[i];
-                items[i] = items[--itemCount];
-                return;
-            }
-        }
-        cout << "Item not found!" << endl;
-    }
-
-    // Display all items by category
-    void displayItemsByCategory(int category) override {
-        if (!isValidCategory(category)) {
-            cout << "Category does not exist!" << endl;
-            return;
-        }
-
-        bool found = false;
-        cout << left << setw(10) << "ID" << setw(20) << "Name" << setw(10) << "Quantity" << setw(10) << "Price" << endl;
-        cout << "----------------------------------------------------------" << endl;
-
-        for (int i = 0; i < itemCount; ++i) {
-            if (items[i]->getCategory() == categoryToString(category)) {
-                items[i]->displayItem();
-                found = true;
-            }
-        }
-        if (!found) cout << "No items found in this category." << endl;
-    }
-
-    // Display all items in a table format
-    void displayAllItems() override {
-        if (itemCount == 0) {
-            cout << "No items in the inventory." << endl;
-        } else {
-            cout << left << setw(10) << "ID" << setw(20) << "Name" << setw(10) << "Quantity" << setw(10) << "Price" << setw(15) << "Category" << endl;
-            cout << "---------------------------------------------------------------------" << endl;
-            for (int i = 0; i < itemCount; ++i) {
-                items[i]->displayItem();
-            }
-        }
-    }
-
-    // Search item by ID
-    void searchItem(const string id) override {
-        for (int i = 0; i < itemCount; ++i) {
-            if (items[i]->getId() == id) {
-                cout << left << setw(10) << "ID" << setw(20) << "Name" << setw(10) << "Quantity" << setw(10) << "Price" << setw(15) << "Category" << endl;
-                cout << "---------------------------------------------------------------------" << endl;
-                items[i]->displayItem();
-                return;
-            }
-        }
-        cout << "Item not found!" << endl;
-    }
-
-    // Sort items (by quantity or price, ascending or descending)
-    void sortItems(bool byQuantity, bool ascending) override {
-        for (int i = 0; i < itemCount - 1; ++i) {
-            for (int j = 0; j < itemCount - i - 1; ++j) {
-                bool condition;
-
-                if (byQuantity) {
-                    // Sorting by quantity
-                    condition = ascending
-                                ? (items[j]->getQuantity() > items[j + 1]->getQuantity())
-                                : (items[j]->getQuantity() < items[j + 1]->getQuantity());
-                } else {
-                    // Sorting by price
-                    condition = ascending
-                                ? (items[j]->getPrice() > items[j + 1]->getPrice())
-                                : (items[j]->getPrice() < items[j + 1]->getPrice());
-                }
-
-                // Swap if the condition is met
-                if (condition) {
-                    Item* temp = items[j];
-                    items[j] = items[j + 1];
-                    items[j + 1] = temp;
-                }
-            }
-        }
-
-        // Display sorted items
-        cout << left << setw(10) << "ID" << setw(20) << "Name" << setw(10) << "Quantity" << setw(10) << "Price" << setw(15) << "Category" << endl;
-        cout << "----------------------------------------------------------" << endl;
-        for (int i = 0; i < itemCount; ++i) {
-            items[i]->displayItem();
-        }
-    }
-
-    // Display low stock items
-    void displayLowStockItems() override {
-        bool found = false;
-        cout << left << setw(10) << "ID" << setw(20) << "Name" << setw(10) << "Quantity" << setw(10) << "Price" << setw(15) << "Category" << endl;
-        cout << "---------------------------------------------------------------------" << endl;
-        for (int i = 0; i < itemCount; ++i) {
-            if (items[i]->getQuantity() <= 5) {
-                items[i]->displayItem();
-                found = true;
-            }
-        }
-        if (!found) cout << "No low stock items found." << endl;
-    }
-
 
-};
+#include "batch_runner.h"
+#include "csv_import.h"
+#include "inventory.h"
+#include "item_export.h"
+#include "journal.h"
+#include "mapped_inventory.h"
+#include "snapshot.h"
+using namespace std;
 
 bool isValidItemId(const string& id) {
     // if (id.length() != 3) {
     //     cout << "Invalid ID. It should must be three numbers." << endl;
     //     return false;
     // }
-    for (size_t i = 0; i < id.length(); ++i) {
-        if (!isalnum(id[i])) {
-            cout << "Invalid ID. Try again" << endl;
-            return false;
-        }
+    if (!validItemId(id.data(), id.length())) {
+        cout << "Invalid ID. Try again" << endl;
+        return false;
     }
     return true;
 }
@@ -331,8 +56,115 @@ int getValidInt() {
     }
 }
 
-int main() {
-    Inventory inventory;
+// A query bound: a number, or - to leave it unchanged (no bound)
+void getOptionalInt(int& bound) {
+    string word;
+    while (true) {
+        cin >> word;
+        if (word == "-" || parseInt(word.data(), word.data() + word.length(), bound)) return;
+        cout << "Invalid input. Please enter a whole number or -: ";
+    }
+}
+
+void getOptionalDouble(double& bound) {
+    string word;
+    while (true) {
+        cin >> word;
+        if (word == "-" || parseDouble(word.data(), word.data() + word.length(), bound)) return;
+        cout << "Invalid input. Please enter a number or -: ";
+    }
+}
+
+// Call counts and latencies of the operations run so far, in microseconds
+void displayOperationStats() {
+    if (!OperationStats::enabled()) {
+        cout << "Statistics are not recorded in this build." << endl;
+        return;
+    }
+    StreamSink console(cout);
+    TableWriter table(console);
+    const char* headings[] = {"Calls", "Mean us", "p50 us", "p90 us", "p99 us", "p99.9 us", "Max us"};
+    table.cell("Operation", 12);
+    for (const char* heading : headings) table.cell(heading, 12);
+    table.endRow();
+    bool any = false;
+    for (size_t op = 0; op < operationCount; ++op) {
+        OperationSummary summary = OperationStats::summary(static_cast<Operation>(op));
+        if (summary.calls == 0) continue;
+        table.cell(operationName(static_cast<Operation>(op)), 12);
+        table.cell(static_cast<long long>(summary.calls), 12);
+        const uint64_t latencies[] = {summary.meanNs(), summary.percentileNs(0.5), summary.percentileNs(0.9),
+                                      summary.percentileNs(0.99), summary.percentileNs(0.999), summary.maxNs()};
+        for (uint64_t ns : latencies) table.cell(ns / 1000.0, 12);
+        table.endRow();
+        any = true;
+    }
+    if (!any) table.line("No operations recorded yet.");
+    table.flush();
+}
+
+int main(int argc, char* argv[]) {
+    Inventory editable;
+    MappedInventory mapped;
+    Journal journal;
+    string dataPath;
+    string batchPath;
+    bool readOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--mmap" && i + 1 < argc) {
+            // Serve a snapshot read-only, straight from the file
+            string error;
+            if (!mapped.open(argv[++i], error)) {
+                cout << "Cannot open snapshot: " << error << endl;
+                return 1;
+            }
+            readOnly = true;
+        } else if (arg == "--data" && i + 1 < argc) {
+            // Keep the inventory in a snapshot plus write-ahead journal
+            dataPath = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            // Run commands from a file (- for standard input) instead of the menu
+            batchPath = argv[++i];
+        } else {
+            cout << "Usage: " << argv[0] << " [--mmap snapshot | --data path] [--batch commands]" << endl;
+            return 1;
+        }
+    }
+
+    bool durable = !dataPath.empty() && !readOnly;
+    if (durable) {
+        string error;
+        if (!openJournaledInventory(editable, dataPath, journal, error)) {
+            cout << "Cannot open inventory data: " << error << endl;
+            return 1;
+        }
+    }
+
+    if (!batchPath.empty()) {
+        if (readOnly) {
+            cout << "Batch mode needs an editable inventory." << endl;
+            return 1;
+        }
+        int fd = batchPath == "-" ? 0 : openInputFile(batchPath);
+        if (fd < 0) {
+            cout << "Cannot open " << batchPath << endl;
+            return 1;
+        }
+        FileSink standardOutput(stdout);
+        BatchRunner runner(editable, standardOutput);
+        if (durable) runner.setJournal(&journal, dataPath);
+        BatchReport report;
+        bool ok = runner.run(fd, report);
+        if (fd != 0) closeFile(fd);
+        cerr << "Ran " << report.commands << " commands (" << report.errors << " failed) in " << report.seconds
+             << "s, " << static_cast<long long>(report.commandsPerSecond()) << " commands/sec." << endl;
+        return ok ? 0 : 1;
+    }
+
+    InventoryBase& inventory = readOnly ? static_cast<InventoryBase&>(mapped) : editable;
+    ItemScanner scanner;
     string choice;
 
     do {
@@ -346,13 +178,21 @@ int main() {
         cout << "[7] - Sort Items\n";
         cout << "[8] - Display Low Stock Items\n";
         cout << "[9] - Exit\n";
+        cout << "[10] - Save Inventory\n";
+        cout << "[11] - Load Inventory\n";
+        cout << "[12] - Import Items from CSV\n";
+        cout << "[13] - Export Items\n";
+        cout << "[14] - Find Items\n";
+        cout << "[15] - Show Statistics\n";
         cout << "==============================================\n";
         cout << "Enter your choice: ";
         cin >> choice;
 
         if (cin.fail() || (choice != "1" && choice != "2" && choice != "3" &&
                            choice != "4" && choice != "5" && choice != "6" &&
-                           choice != "7" && choice != "8" && choice != "9")) {
+                           choice != "7" && choice != "8" && choice != "9" &&
+                           choice != "10" && choice != "11" && choice != "12" &&
+                           choice != "13" && choice != "14" && choice != "15")) {
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
             cout << "\nInvalid input. Please enter a valid option." << endl;
@@ -471,13 +311,13 @@ int main() {
                 int sortType, sortOrder;
 
                 while (true) {
-                    cout << "\n[1] Sort by Quantity\n[2] Sort by Price\nEnter choice: ";
+                    cout << "\n[1] Sort by Quantity\n[2] Sort by Price\n[3] Sort by Category, then Price\nEnter choice: ";
                     sortType = getValidInt();
 
-                    if (sortType == 1 || sortType == 2) {
+                    if (sortType == 1 || sortType == 2 || sortType == 3) {
                         break;
                     } else {
-                        cout << "Invalid choice. Please enter 1 or 2." << endl;
+                        cout << "Invalid choice. Please enter 1, 2, or 3." << endl;
                     }
                 }
 
@@ -496,7 +336,11 @@ int main() {
 
                 bool ascending = (sortOrder == 1);
                 cout << "\n";
-                inventory.sortItems(byQuantity, ascending);
+                if (sortType == 3) {
+                    inventory.sortItems({SortKey{SortField::Category, true}, SortKey{SortField::Price, ascending}});
+                } else {
+                    inventory.sortItems(byQuantity, ascending);
+                }
             }
             cout << "\n";
         }
@@ -511,6 +355,165 @@ int main() {
             }
         }
 
+        else if (choice == "10" && readOnly) {
+            cout << "Inventory is read-only." << endl;
+        }
+
+        else if (choice == "10") {
+            string path;
+            cout << "\nEnter file name to save to: ";
+            cin >> path;
+            string error;
+            if (saveSnapshot(editable, path, error)) {
+                cout << "Saved " << inventory.getItemCount() << " items to " << path << "." << endl;
+            } else {
+                cout << "Save failed: " << error << endl;
+            }
+            cout << "\n";
+        }
+
+        else if (choice == "11" && readOnly) {
+            cout << "Inventory is read-only." << endl;
+        }
+
+        else if (choice == "11") {
+            string path;
+            cout << "\nEnter file name to load from: ";
+            cin >> path;
+            string error;
+            // A loaded snapshot replaces everything, so record it as a new
+            // base snapshot rather than journaling each item
+            if (durable) editable.setObserver(nullptr);
+            if (loadSnapshot(editable, path, error)) {
+                cout << "Loaded " << inventory.getItemCount() << " items from " << path << "." << endl;
+                if (durable && !compactJournal(editable, dataPath, journal, error)) {
+                    cout << "Journal write failed: " << error << endl;
+                }
+            } else {
+                cout << "Load failed: " << error << endl;
+            }
+            if (durable) editable.setObserver(&journal);
+            cout << "\n";
+        }
+
+        else if (choice == "12" && readOnly) {
+            cout << "Inventory is read-only." << endl;
+        }
+
+        else if (choice == "12") {
+            string path;
+            cout << "\nEnter CSV or TSV file to import: ";
+            cin >> path;
+            string error;
+            ImportReport report;
+            CsvImporter importer;
+            // Like a load, a bulk import goes straight into a new snapshot
+            if (durable) editable.setObserver(nullptr);
+            if (importer.import(editable, path, report, error)) {
+                cout << "Imported " << report.imported << " of " << report.rows << " rows from " << path << " ("
+                     << report.rejected << " rejected, " << report.duplicates << " duplicate IDs, "
+                     << static_cast<long long>(report.rowsPerSecond()) << " rows/sec)." << endl;
+                for (const string& rejection : report.rejections) {
+                    cout << "  " << rejection << endl;
+                }
+                if (report.rejected > report.rejections.size()) {
+                    cout << "  ..." << endl;
+                }
+                if (durable && !compactJournal(editable, dataPath, journal, error)) {
+                    cout << "Journal write failed: " << error << endl;
+                }
+            } else {
+                cout << "Import failed: " << error << endl;
+            }
+            if (durable) editable.setObserver(&journal);
+            cout << "\n";
+        }
+
+        else if (choice == "13" && readOnly) {
+            cout << "Export is not available for a mapped snapshot." << endl;
+        }
+
+        else if (choice == "13") {
+            int format, order;
+            while (true) {
+                cout << "\nSelect format:\n[1] CSV\n[2] JSON Lines\nEnter choice: ";
+                format = getValidInt();
+                if (format == 1 || format == 2) break;
+                cout << "Invalid choice! Please enter 1 or 2." << endl;
+            }
+            while (true) {
+                cout << "\nSelect order:\n[1] As stored\n[2] By category\n[3] Quantity (ascending)\n"
+                        "[4] Quantity (descending)\n[5] Price (ascending)\n[6] Price (descending)\nEnter choice: ";
+                order = getValidInt();
+                if (order >= 1 && order <= 6) break;
+                cout << "Invalid choice! Please enter a number from 1 to 6." << endl;
+            }
+            const ExportOrder orders[] = {ExportOrder::Stored, ExportOrder::Category, ExportOrder::Quantity,
+                                          ExportOrder::Quantity, ExportOrder::Price, ExportOrder::Price};
+
+            string path;
+            cout << "Enter file name to export to (- for standard output): ";
+            cin >> path;
+            cout << flush;
+            fflush(stdout);
+            int fd = path == "-" ? 1 : openOutputFile(path);
+            size_t count = 0;
+            string error;
+            if (fd < 0) {
+                cout << "Export failed: cannot open " << path << endl;
+            } else {
+                bool ok = exportItems(editable, fd, format == 1 ? ExportFormat::Csv : ExportFormat::JsonLines,
+                                      orders[order - 1], order != 4 && order != 6, count, error);
+                if (fd != 1 && !closeFile(fd) && ok) {
+                    ok = false;
+                    error = "cannot close " + path;
+                }
+                if (ok) {
+                    cout << "Exported " << count << " items to " << (path == "-" ? "standard output" : path) << "."
+                         << endl;
+                } else {
+                    cout << "Export failed: " << error << endl;
+                }
+            }
+            cout << "\n";
+        }
+
+        else if (choice == "14" && readOnly) {
+            cout << "Find is not available for a mapped snapshot." << endl;
+        }
+
+        else if (choice == "14") {
+            ItemQuery query;
+            cout << "\nEnter - to skip a condition.";
+            while (true) {
+                cout << "\nSelect category:\n[1] Clothing\n[2] Electronics\n[3] Entertainment\nEnter choice: ";
+                getOptionalInt(query.category);
+                if (query.category >= 0 && query.category <= 3) break;
+                cout << "Invalid choice! Please enter 1, 2, 3 or -." << endl;
+                query.category = 0;
+            }
+            cout << "Enter minimum quantity: ";
+            getOptionalInt(query.minQuantity);
+            cout << "Enter maximum quantity: ";
+            getOptionalInt(query.maxQuantity);
+            cout << "Enter minimum price: ";
+            getOptionalDouble(query.minPrice);
+            cout << "Enter maximum price: ";
+            getOptionalDouble(query.maxPrice);
+            cout << "Enter text the name contains: ";
+            cin >> query.nameContains;
+            if (query.nameContains == "-") query.nameContains.clear();
+            cout << "\n";
+            editable.displayMatchingItems(scanner, query);
+            cout << "\n";
+        }
+
+        else if (choice == "15") {
+            cout << "\n";
+            displayOperationStats();
+            cout << "\n";
+        }
+
         else if (choice == "9") {
             cout << "\n";
             cout << "Exiting program..." << endl;
@@ -521,6 +524,16 @@ int main() {
             cout << endl;
             continue;
         }
+
+        // Make the command's changes durable before the next prompt
+        if (durable) {
+            string error;
+            if (!journal.commit()) {
+                cout << "Journal write failed: " << journal.error() << endl;
+            } else if (journal.needsCompaction() && !compactJournal(editable, dataPath, journal, error)) {
+                cout << "Journal compaction failed: " << error << endl;
+            }
+        }
     } while (choice != "9");
 
     return 0;
@@ -0,0 +1,107 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file. Pages are loaded on first access
+// and shared with every other process mapping the same file.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    uint64_t length = 0;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            error = "cannot open " + path;
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            error = "cannot map " + path;
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            error = "cannot map " + path;
+            return false;
+        }
+        bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (bytes == nullptr) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            error = "cannot map " + path;
+            return false;
+        }
+        length = static_cast<uint64_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            error = "cannot map " + path;
+            return false;
+        }
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            error = "cannot map " + path;
+            return false;
+        }
+        bytes = static_cast<const char*>(address);
+        length = static_cast<uint64_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+        if (bytes == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(const_cast<char*>(bytes), static_cast<size_t>(length));
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return bytes != nullptr; }
+    const char* data() const { return bytes; }
+    uint64_t size() const { return length; }
+};
+
+#endif
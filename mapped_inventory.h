@@ -0,0 +1,268 @@
+#ifndef MAPPED_INVENTORY_H
+#define MAPPED_INVENTORY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "inventory.h"
+#include "item.h"
+#include "mapped_file.h"
+#include "snapshot.h"
+
+// Read-only inventory served straight from a memory-mapped snapshot.
+//
+// Opening only maps the file and checks its headers; nothing is
+// deserialized into Item objects. Searches probe the snapshot's ID hash
+// table, category listings and sorted views walk its precomputed record
+// lists, and the low-stock report walks the quantity order until it passes
+// the largest threshold. Several processes serving the same snapshot share
+// one copy of it in the page cache.
+//
+// Records are checked when they are displayed rather than all at open, so a
+// damaged record is skipped instead of delaying startup.
+class MappedInventory: public InventoryBase {
+private:
+    MappedFile file;
+    uint64_t count = 0;
+    uint64_t stringsSize = 0;
+    uint64_t hashMask = 0;
+    const SnapshotRecord* records = nullptr;
+    const char* strings = nullptr;
+    const uint32_t* buckets = nullptr;
+    const uint32_t* categoryRecords[categoryCount] = {};
+    uint64_t categorySizes[categoryCount] = {};
+    const uint32_t* quantityOrder = nullptr;
+    const uint32_t* priceOrder = nullptr;
+    int thresholds[categoryCount];
+
+    template <typename T>
+    const T* section(uint64_t offset) const {
+        return reinterpret_cast<const T*>(file.data() + offset);
+    }
+
+    const SnapshotRecord* record(uint32_t number) const {
+        if (number >= count || !validSnapshotRecord(records[number], strings, stringsSize)) return nullptr;
+        return &records[number];
+    }
+
+    void displayRecord(uint32_t number) {
+        const SnapshotRecord* r = record(number);
+        if (r == nullptr) return;
+        const char* text = strings + r->textOffset;
+        displayItemRow(table, text, r->idLength, text + r->idLength, r->nameLength, r->quantity, r->price,
+                       static_cast<Category>(r->category));
+    }
+
+    bool findRecord(TextView id, uint32_t& number) const {
+        if (buckets == nullptr) return false;
+        uint64_t b = hashItemId(id.data(), id.length()) & hashMask;
+        for (uint64_t probes = 0; probes <= hashMask; ++probes, b = (b + 1) & hashMask) {
+            uint32_t entry = buckets[b];
+            if (entry == 0) return false;
+            const SnapshotRecord* r = record(entry - 1);
+            if (r == nullptr || r->idLength != id.length()) continue;
+            const char* stored = strings + r->textOffset;
+            size_t i = 0;
+            while (i < id.length() && foldIdChar(stored[i]) == foldIdChar(id[i])) ++i;
+            if (i == id.length()) {
+                number = entry - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void displayOrder(const uint32_t* order, bool ascending, uint64_t limit) {
+        writeSortedHeader();
+        uint64_t shown = std::min(limit, count);
+        for (uint64_t i = 0; i < shown; ++i) {
+            displayRecord(order[ascending ? i : count - 1 - i]);
+        }
+        table.flush();
+    }
+
+    void readOnly() const {
+        std::cout << "Inventory is read-only." << std::endl;
+    }
+
+public:
+    MappedInventory() {
+        for (int& threshold : thresholds) threshold = LowStockIndex::defaultThreshold;
+    }
+
+    // Map a version 2 (or later) snapshot
+    bool open(const std::string& path, std::string& error) {
+        count = 0;
+        buckets = nullptr;
+        if (!file.open(path, error)) return false;
+        if (file.size() < sizeof(SnapshotHeader) + sizeof(SnapshotIndexHeader)) {
+            file.close();
+            error = "not an inventory snapshot";
+            return false;
+        }
+
+        const SnapshotHeader& header = *section<SnapshotHeader>(0);
+        if (!validSnapshotHeader(header, file.size(), error)) {
+            file.close();
+            return false;
+        }
+        if (header.version < 2) {
+            file.close();
+            error = "snapshot has no indexes; load and save it again to add them";
+            return false;
+        }
+        const SnapshotIndexHeader& indexes = *section<SnapshotIndexHeader>(sizeof(SnapshotHeader));
+        if (!validSnapshotIndexHeader(header, indexes, file.size(), error)) {
+            file.close();
+            return false;
+        }
+        if (header.recordsOffset % 8 != 0) {
+            file.close();
+            error = "snapshot is truncated or corrupt";
+            return false;
+        }
+
+        count = header.itemCount;
+        stringsSize = header.stringsSize;
+        records = section<SnapshotRecord>(header.recordsOffset);
+        strings = section<char>(header.stringsOffset);
+        buckets = section<uint32_t>(indexes.hashOffset);
+        hashMask = indexes.hashBuckets - 1;
+        uint64_t categoryOffset = indexes.categoryOffset;
+        for (int c = 0; c < categoryCount; ++c) {
+            categoryRecords[c] = section<uint32_t>(categoryOffset);
+            categorySizes[c] = indexes.categorySizes[c];
+            categoryOffset += indexes.categorySizes[c] * sizeof(uint32_t);
+        }
+        quantityOrder = section<uint32_t>(indexes.quantityOrderOffset);
+        priceOrder = section<uint32_t>(indexes.priceOrderOffset);
+        return true;
+    }
+
+    int getItemCount() const override { return static_cast<int>(count); }
+
+    void setLowStockThreshold(int threshold) {
+        for (int& t : thresholds) t = threshold;
+    }
+
+    void setLowStockThreshold(Category category, int threshold) {
+        thresholds[static_cast<int>(category) - 1] = threshold;
+    }
+
+    void addItem(TextView, TextView, int, double, int) override { readOnly(); }
+
+    void updateItem(TextView) override { readOnly(); }
+
+    UpdateStatus setQuantity(TextView, int) override { return UpdateStatus::ReadOnly; }
+    UpdateStatus adjustQuantity(TextView, int) override { return UpdateStatus::ReadOnly; }
+    UpdateStatus setPrice(TextView, double) override { return UpdateStatus::ReadOnly; }
+
+    void removeItem(TextView) override { readOnly(); }
+
+    void displayItemsByCategory(int category) override {
+        TIME_OPERATION(Operation::ListCategory);
+        if (!isValidCategory(category)) {
+            std::cout << "Category does not exist!" << std::endl;
+            return;
+        }
+
+        writeCategoryHeader();
+        const uint32_t* members = categoryRecords[category - 1];
+        uint64_t size = categorySizes[category - 1];
+        for (uint64_t i = 0; i < size; ++i) {
+            displayRecord(members[i]);
+        }
+        if (size == 0) table.line("No items found in this category.");
+        table.flush();
+    }
+
+    void displayAllItems() override {
+        TIME_OPERATION(Operation::ListAll);
+        if (count == 0) {
+            std::cout << "No items in the inventory." << std::endl;
+            return;
+        }
+        writeFullHeader();
+        for (uint64_t i = 0; i < count; ++i) {
+            displayRecord(static_cast<uint32_t>(i));
+        }
+        table.flush();
+    }
+
+    void searchItem(TextView id) override {
+        TIME_OPERATION(Operation::Search);
+        uint32_t number;
+        if (!findRecord(id, number)) {
+            std::cout << "Item not found!" << std::endl;
+            return;
+        }
+        writeFullHeader();
+        displayRecord(number);
+        table.flush();
+    }
+
+    void sortItems(bool byQuantity, bool ascending) override {
+        TIME_OPERATION(Operation::Sort);
+        displayOrder(byQuantity ? quantityOrder : priceOrder, ascending, count);
+    }
+
+    // Orderings the snapshot has no list for are sorted on demand
+    void sortItems(const std::vector<SortKey>& keys) override {
+        TIME_OPERATION(Operation::Sort);
+        std::vector<uint32_t> order(count);
+        for (uint64_t i = 0; i < count; ++i) order[i] = static_cast<uint32_t>(i);
+        const SnapshotRecord* all = records;
+        std::stable_sort(order.begin(), order.end(), [&keys, all](uint32_t a, uint32_t b) {
+            for (const SortKey& key : keys) {
+                const SnapshotRecord& x = all[key.ascending ? a : b];
+                const SnapshotRecord& y = all[key.ascending ? b : a];
+                switch (key.field) {
+                    case SortField::Quantity:
+                        if (x.quantity != y.quantity) return x.quantity < y.quantity;
+                        break;
+                    case SortField::Price:
+                        if (x.price != y.price) return x.price < y.price;
+                        break;
+                    case SortField::Category:
+                        if (x.category != y.category) return x.category < y.category;
+                        break;
+                }
+            }
+            return false;
+        });
+        writeSortedHeader();
+        for (uint32_t number : order) {
+            displayRecord(number);
+        }
+        table.flush();
+    }
+
+    void displayTopItems(bool byQuantity, bool ascending, int limit) override {
+        TIME_OPERATION(Operation::Sort);
+        displayOrder(byQuantity ? quantityOrder : priceOrder, ascending, limit > 0 ? static_cast<uint64_t>(limit) : 0);
+    }
+
+    // Walks the quantity order up to the largest threshold
+    void displayLowStockItems() override {
+        TIME_OPERATION(Operation::LowStock);
+        int highest = *std::max_element(thresholds, thresholds + categoryCount);
+        bool found = false;
+        writeFullHeader();
+        for (uint64_t i = 0; i < count; ++i) {
+            const SnapshotRecord* r = record(quantityOrder[i]);
+            if (r == nullptr) continue;
+            if (r->quantity > highest) break;
+            if (r->quantity <= thresholds[r->category - 1]) {
+                displayRecord(quantityOrder[i]);
+                found = true;
+            }
+        }
+        if (!found) table.line("No low stock items found.");
+        table.flush();
+    }
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef NUMBER_PARSER_H
+#define NUMBER_PARSER_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+// Locale-independent number parsing over [first, last) for the bulk import
+// and batch paths. The whole range must be the number: no surrounding
+// spaces or trailing characters.
+
+inline bool parseInt(const char* first, const char* last, int& value) {
+    bool negative = false;
+    if (first != last && (*first == '+' || *first == '-')) negative = *first++ == '-';
+    if (first == last) return false;
+
+    const int64_t limit = negative ? -static_cast<int64_t>(std::numeric_limits<int>::min())
+                                   : std::numeric_limits<int>::max();
+    int64_t result = 0;
+    for (; first != last; ++first) {
+        unsigned digit = static_cast<unsigned>(*first - '0');
+        if (digit > 9) return false;
+        result = result * 10 + digit;
+        if (result > limit) return false;
+    }
+    value = static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+// Decimal or scientific notation. Values with at most 19 significant digits
+// and a small exponent (the usual price) are converted exactly with one
+// multiply or divide; anything else falls back to strtod.
+inline bool parseDouble(const char* first, const char* last, double& value) {
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* start = first;
+    bool negative = false;
+    if (first != last && (*first == '+' || *first == '-')) negative = *first++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;      // significant digits kept in mantissa
+    int exponent = 0;    // decimal exponent applied to mantissa
+    bool anyDigits = false;
+    bool exact = true;
+    for (; first != last && static_cast<unsigned>(*first - '0') <= 9; ++first) {
+        anyDigits = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*first - '0');
+            if (mantissa != 0) ++digits;
+        } else {
+            ++exponent;
+            exact = false;
+        }
+    }
+    if (first != last && *first == '.') {
+        for (++first; first != last && static_cast<unsigned>(*first - '0') <= 9; ++first) {
+            anyDigits = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*first - '0');
+                if (mantissa != 0) ++digits;
+                --exponent;
+            } else {
+                exact = false;
+            }
+        }
+    }
+    if (!anyDigits) return false;
+    if (first != last && (*first == 'e' || *first == 'E')) {
+        ++first;
+        bool negativeExponent = false;
+        if (first != last && (*first == '+' || *first == '-')) negativeExponent = *first++ == '-';
+        if (first == last) return false;
+        int written = 0;
+        for (; first != last && static_cast<unsigned>(*first - '0') <= 9; ++first) {
+            if (written < 100000) written = written * 10 + (*first - '0');
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (first != last) return false;
+
+    if (exact && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+
+    std::string text(start, last);
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.length() && std::isfinite(value);
+}
+
+#endif
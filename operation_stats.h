@@ -0,0 +1,292 @@
+#ifndef OPERATION_STATS_H
+#define OPERATION_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Call counts and latency histograms for inventory operations.
+//
+// Operations are timed with TIME_OPERATION(op) at the top of the scope that
+// does the work. Every operation is measured over the same span: from the
+// ID lookup (or the start of the listing) to its result, including any
+// table it renders. Reading the menu prompts or parsing batch arguments is
+// not counted. Builds with INVENTORY_STATS=0 turn the macro into nothing,
+// so the operations carry no timing code at all; by default it is on.
+//
+// Each thread records into a block of its own, so recording is two clock
+// reads and a few uncontended relaxed stores. Reading merges every thread's
+// block, plus those of threads that have ended. Latencies go into
+// HDR-style log-linear buckets: exact below 16 ns, then 16 buckets per
+// power of two, so a percentile is within about 3% of the true value. The
+// buckets run up to 2^41 ns, about 36.6 minutes; slower calls count in the
+// top bucket. The slowest call is also kept on its own, exactly.
+
+#ifndef INVENTORY_STATS
+#define INVENTORY_STATS 1
+#endif
+
+enum class Operation : uint8_t {
+    Add,
+    Update,
+    Remove,
+    Search,
+    ListCategory,
+    ListAll,
+    Sort,
+    LowStock,
+    Find
+};
+
+const size_t operationCount = 9;
+
+inline const char* operationName(Operation operation) {
+    switch (operation) {
+        case Operation::Add: return "add";
+        case Operation::Update: return "update";
+        case Operation::Remove: return "remove";
+        case Operation::Search: return "search";
+        case Operation::ListCategory: return "category";
+        case Operation::ListAll: return "list";
+        case Operation::Sort: return "sort";
+        case Operation::LowStock: return "low stock";
+        case Operation::Find: return "find";
+    }
+    return "";
+}
+
+struct LatencyBuckets {
+    static const unsigned subBucketBits = 4;
+    static const size_t count = (42 - subBucketBits) << subBucketBits;
+
+    static size_t of(uint64_t ns) {
+        if (ns < (1u << subBucketBits)) return static_cast<size_t>(ns);
+        if (ns >= 1ull << 41) ns = (1ull << 41) - 1;
+#ifdef __GNUC__
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+#else
+        unsigned exponent = 0;
+        while (ns >> (exponent + 1)) ++exponent;
+#endif
+        size_t sub = static_cast<size_t>(ns >> (exponent - subBucketBits)) & ((1u << subBucketBits) - 1);
+        return ((exponent - subBucketBits + 1) << subBucketBits) + sub;
+    }
+
+    // Smallest latency in the bucket, and the width of the bucket
+    static uint64_t lowest(size_t bucket) {
+        if (bucket < (1u << subBucketBits)) return bucket;
+        unsigned shift = static_cast<unsigned>(bucket >> subBucketBits) - 1;
+        return ((1ull << subBucketBits) + (bucket & ((1u << subBucketBits) - 1))) << shift;
+    }
+
+    static uint64_t width(size_t bucket) {
+        return bucket < (1u << subBucketBits) ? 1 : 1ull << ((bucket >> subBucketBits) - 1);
+    }
+};
+
+// Merged statistics of one operation
+struct OperationSummary {
+    uint64_t calls = 0;
+    uint64_t totalNs = 0;
+    uint64_t slowestNs = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyBuckets::count);
+
+    uint64_t meanNs() const { return calls > 0 ? totalNs / calls : 0; }
+
+    // Latency that a fraction p of the calls did not exceed (the middle of
+    // its bucket, but no more than the slowest call, which is the answer
+    // when the rank is the last); 0 without calls
+    uint64_t percentileNs(double p) const {
+        uint64_t recorded = 0;
+        for (uint64_t count : buckets) recorded += count;
+        if (recorded == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * recorded);
+        if (rank < 1) rank = 1;
+        if (rank > recorded) rank = recorded;
+        if (rank == recorded && slowestNs > 0) return slowestNs;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); ++b) {
+            seen += buckets[b];
+            if (seen >= rank) {
+                uint64_t middle = LatencyBuckets::lowest(b) + LatencyBuckets::width(b) / 2;
+                return slowestNs > 0 && slowestNs < middle ? slowestNs : middle;
+            }
+        }
+        return 0;
+    }
+
+    uint64_t maxNs() const { return slowestNs; }
+};
+
+class OperationStats {
+private:
+    // The slowest call is kept with the reset() epoch it was recorded in,
+    // in the top bits, so a reset can drop it without writing to the
+    // block; times are capped at 2^48 ns (about 78 hours)
+    static const unsigned epochShift = 48;
+    static const uint64_t slowestMask = (1ull << epochShift) - 1;
+
+    // Written only by its thread
+    struct ThreadBlock {
+        std::atomic<uint64_t> calls[operationCount];
+        std::atomic<uint64_t> totalNs[operationCount];
+        std::atomic<uint64_t> slowest[operationCount];
+        std::atomic<uint64_t> buckets[operationCount][LatencyBuckets::count];
+    };
+
+    struct Registry {
+        std::mutex lock;
+        std::vector<ThreadBlock*> blocks;
+        OperationSummary retired[operationCount]; // from threads that have ended
+        OperationSummary baseline[operationCount]; // subtracted, set by reset()
+        std::atomic<uint64_t> epoch{0};             // reset() count, in the slowest bits
+    };
+
+    static Registry& registry() {
+        static Registry shared;
+        return shared;
+    }
+
+    // Hands a thread's counts to the registry when the thread ends
+    struct Owner {
+        ThreadBlock* block = nullptr;
+
+        ~Owner() {
+            if (block == nullptr) return;
+            Registry& shared = registry();
+            std::lock_guard<std::mutex> guard(shared.lock);
+            for (size_t op = 0; op < operationCount; ++op) add(shared.retired[op], *block, op, shared.epoch);
+            for (size_t i = 0; i < shared.blocks.size(); ++i) {
+                if (shared.blocks[i] == block) {
+                    shared.blocks[i] = shared.blocks.back();
+                    shared.blocks.pop_back();
+                    break;
+                }
+            }
+            delete block;
+        }
+    };
+
+    static ThreadBlock& threadBlock() {
+        static thread_local Owner owner;
+        if (owner.block == nullptr) {
+            owner.block = new ThreadBlock(); // value-initialized: all zero
+            Registry& shared = registry();
+            std::lock_guard<std::mutex> guard(shared.lock);
+            shared.blocks.push_back(owner.block);
+        }
+        return *owner.block;
+    }
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void add(OperationSummary& summary, const ThreadBlock& block, size_t op,
+                    const std::atomic<uint64_t>& epoch) {
+        summary.calls += block.calls[op].load(std::memory_order_relaxed);
+        summary.totalNs += block.totalNs[op].load(std::memory_order_relaxed);
+        uint64_t slowest = block.slowest[op].load(std::memory_order_relaxed);
+        if (slowest >> epochShift == epoch.load(std::memory_order_relaxed) &&
+            (slowest & slowestMask) > summary.slowestNs) {
+            summary.slowestNs = slowest & slowestMask;
+        }
+        for (size_t b = 0; b < LatencyBuckets::count; ++b) {
+            summary.buckets[b] += block.buckets[op][b].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Totals since the program started (the slowest call since the last
+    // reset()); needs the registry lock
+    static OperationSummary total(Registry& shared, Operation operation) {
+        size_t op = static_cast<size_t>(operation);
+        OperationSummary summary = shared.retired[op];
+        for (const ThreadBlock* block : shared.blocks) add(summary, *block, op, shared.epoch);
+        return summary;
+    }
+
+public:
+    static void record(Operation operation, uint64_t ns) {
+        ThreadBlock& block = threadBlock();
+        size_t op = static_cast<size_t>(operation);
+        bump(block.calls[op], 1);
+        bump(block.totalNs[op], ns);
+        bump(block.buckets[op][LatencyBuckets::of(ns)], 1);
+        uint64_t epoch = registry().epoch.load(std::memory_order_relaxed);
+        uint64_t slowest = block.slowest[op].load(std::memory_order_relaxed);
+        uint64_t capped = ns < slowestMask ? ns : slowestMask;
+        if (slowest >> epochShift != epoch || capped > (slowest & slowestMask)) {
+            block.slowest[op].store(epoch << epochShift | capped, std::memory_order_relaxed);
+        }
+    }
+
+    // Statistics since the last reset(), merged over all threads
+    static OperationSummary summary(Operation operation) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> guard(shared.lock);
+        OperationSummary summary = total(shared, operation);
+        const OperationSummary& baseline = shared.baseline[static_cast<size_t>(operation)];
+        summary.calls -= baseline.calls;
+        summary.totalNs -= baseline.totalNs;
+        for (size_t b = 0; b < summary.buckets.size(); ++b) summary.buckets[b] -= baseline.buckets[b];
+        return summary;
+    }
+
+    // Start counting from zero; the threads' blocks are left alone, so
+    // this never races with record()
+    static void reset() {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> guard(shared.lock);
+        for (size_t op = 0; op < operationCount; ++op) {
+            shared.baseline[op] = total(shared, static_cast<Operation>(op));
+            shared.retired[op].slowestNs = 0;
+        }
+        uint64_t next = (shared.epoch.load(std::memory_order_relaxed) + 1) & (~0ull >> epochShift);
+        shared.epoch.store(next, std::memory_order_relaxed);
+    }
+
+    static bool enabled() { return INVENTORY_STATS != 0; }
+};
+
+// Records the time from its construction to the end of the scope. Only the
+// outermost timer on a thread records, so an operation that calls another
+// (a ConcurrentInventory call going through a shard's Inventory, or a batch
+// command) is counted once, with everything it waited for.
+class OperationTimer {
+private:
+    Operation operation;
+    bool outermost;
+    std::chrono::steady_clock::time_point started;
+
+    static unsigned& depth() {
+        static thread_local unsigned timers = 0;
+        return timers;
+    }
+
+public:
+    explicit OperationTimer(Operation operation) : operation(operation), outermost(depth()++ == 0) {
+        if (outermost) started = std::chrono::steady_clock::now();
+    }
+
+    ~OperationTimer() {
+        --depth();
+        if (!outermost) return;
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - started;
+        OperationStats::record(operation, static_cast<uint64_t>(
+                                              std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+};
+
+#if INVENTORY_STATS
+#define TIME_OPERATION(operation) OperationTimer operationTimer(operation)
+#else
+#define TIME_OPERATION(operation) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef QUANTITY_COUNTER_H
+#define QUANTITY_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+#include "inventory.h"
+
+const size_t cacheLineSize = 64;
+
+// Stock quantity that threads adjust without a lock.
+//
+// adjust() is a compare-and-swap loop rather than a plain fetch_add, so a
+// reservation that would take the quantity below zero (or past INT_MAX) is
+// refused instead of being applied and undone. The value is padded by a
+// full cache line on each side, so counters for different hot items never
+// share a line, whatever alignment the allocator gives.
+//
+// A counter can be closed, which takes its final value and refuses further
+// adjustments until it is opened again with a new quantity. ConcurrentInventory
+// closes a hot item's counter while it works on the item under the shard's
+// write lock, so lock-free adjustments cannot be lost behind its back.
+class QuantityCounter {
+private:
+    static const int closedValue = -1;
+
+    char before[cacheLineSize];
+    std::atomic<int> value;
+    char after[cacheLineSize - sizeof(std::atomic<int>)];
+
+public:
+    explicit QuantityCounter(int initial = 0) : value(initial) {}
+
+    QuantityCounter(const QuantityCounter&) = delete;
+    QuantityCounter& operator=(const QuantityCounter&) = delete;
+
+    int load() const { return value.load(std::memory_order_acquire); }
+    void store(int quantity) { value.store(quantity, std::memory_order_release); }
+
+    // Value before closing; adjustments after this see NotFound
+    int close() { return value.exchange(closedValue, std::memory_order_acq_rel); }
+    void open(int quantity) { store(quantity); }
+    bool isOpen() const { return load() != closedValue; }
+
+    // Add delta (negative to reserve stock); on success result is the new
+    // quantity. NotFound if the counter is closed.
+    UpdateStatus adjust(int delta, int& result) {
+        int current = value.load(std::memory_order_relaxed);
+        while (true) {
+            if (current == closedValue) return UpdateStatus::NotFound;
+            long long next = static_cast<long long>(current) + delta;
+            if (next < 0) return UpdateStatus::InsufficientStock;
+            if (next > std::numeric_limits<int>::max()) return UpdateStatus::InvalidValue;
+            if (value.compare_exchange_weak(current, static_cast<int>(next), std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                result = static_cast<int>(next);
+                return UpdateStatus::Ok;
+            }
+        }
+    }
+};
+
+#endif
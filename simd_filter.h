@@ -0,0 +1,252 @@
+#ifndef SIMD_FILTER_H
+#define SIMD_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_FILTER_X86 1
+#include <immintrin.h>
+#endif
+
+// Filter kernels over ItemStore columns that produce selection bitmaps.
+//
+// A selection bitmap has one bit per row: bit b of word w is set when row
+// 64 * w + b matches. Each kernel writes bitmapWords(rows) words, with the
+// bits past the last row clear, so bitmaps from several kernels over the
+// same rows can be ANDed a word at a time.
+//
+// Kernels come in scalar, SSE2 and AVX2 versions. The SIMD versions are
+// compiled with per-function target attributes, so the program still runs
+// on any x86 processor: filterKernels() picks the widest version the
+// processor supports, once, at first use. Other compilers and processors
+// get the scalar versions. Only whole 64-row words go through the SIMD
+// loops; the last partial word is always done by the scalar code.
+
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::Sse2: return "SSE2";
+        case SimdLevel::Avx2: return "AVX2";
+    }
+    return "";
+}
+
+struct FilterKernels {
+    SimdLevel level;
+    // low <= column[i] <= high
+    void (*intRange)(const int* column, size_t rows, int low, int high, uint64_t* bits);
+    void (*doubleRange)(const double* column, size_t rows, double low, double high, uint64_t* bits);
+    // column[i] == value
+    void (*byteEquals)(const uint8_t* column, size_t rows, uint8_t value, uint64_t* bits);
+};
+
+inline size_t bitmapWords(size_t rows) { return (rows + 63) / 64; }
+
+inline void andBitmap(uint64_t* bits, const uint64_t* other, size_t words) {
+    for (size_t w = 0; w < words; ++w) bits[w] &= other[w];
+}
+
+inline size_t bitmapCount(const uint64_t* bits, size_t words) {
+    size_t count = 0;
+#ifdef __GNUC__
+    for (size_t w = 0; w < words; ++w) count += static_cast<size_t>(__builtin_popcountll(bits[w]));
+#else
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) ++count;
+    }
+#endif
+    return count;
+}
+
+// Index of the lowest set bit; word must not be 0
+inline unsigned lowestBit(uint64_t word) {
+#ifdef __GNUC__
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+struct ScalarFilters {
+    template <typename T>
+    static void range(const T* column, size_t begin, size_t rows, T low, T high, uint64_t* bits) {
+        for (size_t w = begin / 64; w < bitmapWords(rows); ++w) {
+            uint64_t word = 0;
+            size_t end = rows - w * 64 < 64 ? rows - w * 64 : 64;
+            const T* values = column + w * 64;
+            for (size_t b = 0; b < end; ++b) {
+                word |= static_cast<uint64_t>((values[b] >= low) & (values[b] <= high)) << b;
+            }
+            bits[w] = word;
+        }
+    }
+
+    static void intRange(const int* column, size_t rows, int low, int high, uint64_t* bits) {
+        range(column, 0, rows, low, high, bits);
+    }
+
+    static void doubleRange(const double* column, size_t rows, double low, double high, uint64_t* bits) {
+        range(column, 0, rows, low, high, bits);
+    }
+
+    static void byteEquals(const uint8_t* column, size_t rows, uint8_t value, uint64_t* bits) {
+        range(column, 0, rows, value, value, bits);
+    }
+};
+
+#ifdef SIMD_FILTER_X86
+struct Sse2Filters {
+    __attribute__((target("sse2")))
+    static void intRange(const int* column, size_t rows, int low, int high, uint64_t* bits) {
+        const __m128i lows = _mm_set1_epi32(low);
+        const __m128i highs = _mm_set1_epi32(high);
+        size_t words = rows / 64;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            const int* values = column + w * 64;
+            for (unsigned k = 0; k < 16; ++k) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + 4 * k));
+                __m128i outside = _mm_or_si128(_mm_cmpgt_epi32(lows, x), _mm_cmpgt_epi32(x, highs));
+                word |= static_cast<uint64_t>(~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF) << (4 * k);
+            }
+            bits[w] = word;
+        }
+        ScalarFilters::range(column, words * 64, rows, low, high, bits);
+    }
+
+    __attribute__((target("sse2")))
+    static void doubleRange(const double* column, size_t rows, double low, double high, uint64_t* bits) {
+        const __m128d lows = _mm_set1_pd(low);
+        const __m128d highs = _mm_set1_pd(high);
+        size_t words = rows / 64;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            const double* values = column + w * 64;
+            for (unsigned k = 0; k < 32; ++k) {
+                __m128d x = _mm_loadu_pd(values + 2 * k);
+                __m128d inside = _mm_and_pd(_mm_cmpge_pd(x, lows), _mm_cmple_pd(x, highs));
+                word |= static_cast<uint64_t>(_mm_movemask_pd(inside)) << (2 * k);
+            }
+            bits[w] = word;
+        }
+        ScalarFilters::range(column, words * 64, rows, low, high, bits);
+    }
+
+    __attribute__((target("sse2")))
+    static void byteEquals(const uint8_t* column, size_t rows, uint8_t value, uint64_t* bits) {
+        const __m128i values = _mm_set1_epi8(static_cast<char>(value));
+        size_t words = rows / 64;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            const uint8_t* bytes = column + w * 64;
+            for (unsigned k = 0; k < 4; ++k) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 16 * k));
+                word |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, values)) & 0xFFFF) << (16 * k);
+            }
+            bits[w] = word;
+        }
+        ScalarFilters::range(column, words * 64, rows, value, value, bits);
+    }
+};
+
+struct Avx2Filters {
+    __attribute__((target("avx2")))
+    static void intRange(const int* column, size_t rows, int low, int high, uint64_t* bits) {
+        const __m256i lows = _mm256_set1_epi32(low);
+        const __m256i highs = _mm256_set1_epi32(high);
+        size_t words = rows / 64;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            const int* values = column + w * 64;
+            for (unsigned k = 0; k < 8; ++k) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + 8 * k));
+                __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(lows, x), _mm256_cmpgt_epi32(x, highs));
+                word |= static_cast<uint64_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF) << (8 * k);
+            }
+            bits[w] = word;
+        }
+        ScalarFilters::range(column, words * 64, rows, low, high, bits);
+    }
+
+    __attribute__((target("avx2")))
+    static void doubleRange(const double* column, size_t rows, double low, double high, uint64_t* bits) {
+        const __m256d lows = _mm256_set1_pd(low);
+        const __m256d highs = _mm256_set1_pd(high);
+        size_t words = rows / 64;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            const double* values = column + w * 64;
+            for (unsigned k = 0; k < 16; ++k) {
+                __m256d x = _mm256_loadu_pd(values + 4 * k);
+                __m256d inside = _mm256_and_pd(_mm256_cmp_pd(x, lows, _CMP_GE_OQ), _mm256_cmp_pd(x, highs, _CMP_LE_OQ));
+                word |= static_cast<uint64_t>(_mm256_movemask_pd(inside)) << (4 * k);
+            }
+            bits[w] = word;
+        }
+        ScalarFilters::range(column, words * 64, rows, low, high, bits);
+    }
+
+    __attribute__((target("avx2")))
+    static void byteEquals(const uint8_t* column, size_t rows, uint8_t value, uint64_t* bits) {
+        const __m256i values = _mm256_set1_epi8(static_cast<char>(value));
+        size_t words = rows / 64;
+        for (size_t w = 0; w < words; ++w) {
+            const uint8_t* bytes = column + w * 64;
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + 32));
+            uint64_t lowHalf = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, values)));
+            uint64_t highHalf = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, values)));
+            bits[w] = lowHalf | highHalf << 32;
+        }
+        ScalarFilters::range(column, words * 64, rows, value, value, bits);
+    }
+};
+#endif
+
+// Widest kernels the processor supports
+inline SimdLevel detectSimdLevel() {
+#ifdef SIMD_FILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::Sse2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+// Kernels of the given level, or of the widest supported level below it
+inline const FilterKernels& filterKernels(SimdLevel level) {
+    static const FilterKernels scalar = {SimdLevel::Scalar, ScalarFilters::intRange, ScalarFilters::doubleRange,
+                                         ScalarFilters::byteEquals};
+#ifdef SIMD_FILTER_X86
+    static const FilterKernels sse2 = {SimdLevel::Sse2, Sse2Filters::intRange, Sse2Filters::doubleRange,
+                                       Sse2Filters::byteEquals};
+    static const FilterKernels avx2 = {SimdLevel::Avx2, Avx2Filters::intRange, Avx2Filters::doubleRange,
+                                       Avx2Filters::byteEquals};
+    static const SimdLevel supported = detectSimdLevel();
+    if (level > supported) level = supported;
+    if (level == SimdLevel::Avx2) return avx2;
+    if (level == SimdLevel::Sse2) return sse2;
+#else
+    (void)level;
+#endif
+    return scalar;
+}
+
+inline const FilterKernels& filterKernels() {
+    static const FilterKernels& best = filterKernels(SimdLevel::Avx2);
+    return best;
+}
+
+#endif
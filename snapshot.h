@@ -0,0 +1,300 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "file_io.h"
+#include "inventory.h"
+#include "item.h"
+
+// Binary snapshot of an inventory's items.
+//
+// Layout (native byte order, checked on load through byteOrderMark):
+//   SnapshotHeader
+//   SnapshotIndexHeader        version 2 and later
+//   SnapshotRecord[itemCount]  fixed-size records at recordsOffset
+//   string table               the ID and name of every item, back to back,
+//                              at stringsOffset
+//   index sections             version 2 and later, 8-byte aligned
+//
+// Records point into the string table, so a snapshot is read with two bulk
+// reads and no per-item parsing. The index sections hold record numbers
+// (uint32_t) that let a MappedInventory answer queries straight from the
+// mapped file: an open-addressing ID hash table, the records of each
+// category, and the records ordered by quantity and by price.
+
+const char snapshotMagic[8] = {'I', 'N', 'V', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t snapshotVersion = 2;
+const uint32_t snapshotByteOrderMark = 0x01020304u;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t itemCount;
+    uint64_t recordsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+struct SnapshotRecord {
+    double price;
+    uint64_t textOffset; // ID starts here, name follows it
+    uint32_t idLength;
+    uint32_t nameLength;
+    int32_t quantity;
+    uint8_t category;
+    uint8_t reserved[3];
+};
+
+// Index sections, present from version 2
+struct SnapshotIndexHeader {
+    uint64_t hashOffset;  // uint32_t[hashBuckets]: record + 1, 0 when empty
+    uint64_t hashBuckets; // power of two, probed linearly from hashItemId(id)
+    uint64_t categoryOffset; // record numbers grouped by category, in category order
+    uint64_t categorySizes[categoryCount];
+    uint64_t quantityOrderOffset; // uint32_t[itemCount] records by quantity
+    uint64_t priceOrderOffset;    // uint32_t[itemCount] records by price
+};
+
+static_assert(sizeof(SnapshotHeader) == 48, "snapshot header layout");
+static_assert(sizeof(SnapshotIndexHeader) == 64, "snapshot index header layout");
+static_assert(sizeof(SnapshotRecord) == 32, "snapshot record layout");
+
+const size_t snapshotBufferSize = 1 << 20;
+
+inline uint64_t alignSnapshotOffset(uint64_t offset) {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Record numbers (store positions) of the entries of a sorted index
+template <typename Index>
+inline void snapshotOrder(const ItemStore& items, const Index& index, std::vector<uint32_t>& order) {
+    order.clear();
+    for (const auto& entry : index) {
+        order.push_back(static_cast<uint32_t>(items.indexOf(entry.handle)));
+    }
+}
+
+inline bool writeSnapshotSection(FILE* file, uint64_t& written, uint64_t offset, const void* data, size_t size) {
+    static const char padding[8] = {};
+    if (offset > written && !writeBytes(file, padding, static_cast<size_t>(offset - written))) return false;
+    written = offset + size;
+    return writeBytes(file, data, size);
+}
+
+// Write all items to path. The snapshot is written to a temporary file first
+// and renamed into place, so an existing snapshot survives a failed save.
+inline bool saveSnapshot(const Inventory& inventory, const std::string& path, std::string& error) {
+    const ItemStore& items = inventory.getItems();
+    size_t count = items.size();
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, snapshotMagic, sizeof header.magic);
+    header.version = snapshotVersion;
+    header.byteOrderMark = snapshotByteOrderMark;
+    header.itemCount = count;
+    header.recordsOffset = sizeof(SnapshotHeader) + sizeof(SnapshotIndexHeader);
+    header.stringsOffset = header.recordsOffset + count * sizeof(SnapshotRecord);
+    header.stringsSize = 0;
+    for (const Item& item : items) {
+        header.stringsSize += item.getId().length() + item.getName().length();
+    }
+
+    // ID hash table, at most half full
+    std::vector<uint32_t> buckets(16);
+    while (buckets.size() < count * 2) buckets.resize(buckets.size() * 2);
+    size_t mask = buckets.size() - 1;
+    for (size_t i = 0; i < count; ++i) {
+        TextView id = items[i].getId();
+        size_t b = hashItemId(id.data(), id.length()) & mask;
+        while (buckets[b] != 0) b = (b + 1) & mask;
+        buckets[b] = static_cast<uint32_t>(i + 1);
+    }
+
+    SnapshotIndexHeader indexHeader;
+    indexHeader.hashOffset = alignSnapshotOffset(header.stringsOffset + header.stringsSize);
+    indexHeader.hashBuckets = buckets.size();
+    indexHeader.categoryOffset = indexHeader.hashOffset + buckets.size() * sizeof(uint32_t);
+    for (int c = 0; c < categoryCount; ++c) {
+        indexHeader.categorySizes[c] = inventory.getCategoryMembers(static_cast<Category>(c + 1)).size();
+    }
+    indexHeader.quantityOrderOffset = indexHeader.categoryOffset + count * sizeof(uint32_t);
+    indexHeader.priceOrderOffset = indexHeader.quantityOrderOffset + count * sizeof(uint32_t);
+
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        error = "cannot create " + temporary;
+        return false;
+    }
+    std::vector<char> buffer(snapshotBufferSize);
+    setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    bool ok = writeBytes(file, &header, sizeof header) && writeBytes(file, &indexHeader, sizeof indexHeader);
+    uint64_t textOffset = 0;
+    for (size_t i = 0; ok && i < count; ++i) {
+        const Item& item = items[i];
+        SnapshotRecord record;
+        std::memset(&record, 0, sizeof record);
+        record.price = item.getPrice();
+        record.textOffset = textOffset;
+        record.idLength = static_cast<uint32_t>(item.getId().length());
+        record.nameLength = static_cast<uint32_t>(item.getName().length());
+        record.quantity = item.getQuantity();
+        record.category = static_cast<uint8_t>(item.getCategory());
+        textOffset += record.idLength + record.nameLength;
+        ok = writeBytes(file, &record, sizeof record);
+    }
+    for (size_t i = 0; ok && i < count; ++i) {
+        TextView id = items[i].getId();
+        TextView name = items[i].getName();
+        ok = writeBytes(file, id.data(), id.length()) && writeBytes(file, name.data(), name.length());
+    }
+
+    uint64_t written = header.stringsOffset + header.stringsSize;
+    std::vector<uint32_t> records;
+    records.reserve(count);
+    ok = ok && writeSnapshotSection(file, written, indexHeader.hashOffset, buckets.data(), buckets.size() * sizeof(uint32_t));
+    for (int c = 0; c < categoryCount; ++c) {
+        for (ItemHandle handle : inventory.getCategoryMembers(static_cast<Category>(c + 1))) {
+            records.push_back(static_cast<uint32_t>(items.indexOf(handle)));
+        }
+    }
+    ok = ok && writeSnapshotSection(file, written, indexHeader.categoryOffset, records.data(), records.size() * sizeof(uint32_t));
+    snapshotOrder(items, inventory.getQuantityIndex(), records);
+    ok = ok && writeSnapshotSection(file, written, indexHeader.quantityOrderOffset, records.data(), records.size() * sizeof(uint32_t));
+    snapshotOrder(items, inventory.getPriceIndex(), records);
+    ok = ok && writeSnapshotSection(file, written, indexHeader.priceOrderOffset, records.data(), records.size() * sizeof(uint32_t));
+
+    // The snapshot must be on disk, under its final name, before a caller
+    // empties the journal that it replaces
+    ok = ok && syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !replaceFile(temporary, path)) {
+        std::remove(temporary.c_str());
+        error = "cannot write " + path;
+        return false;
+    }
+    if (!syncDirectory(path)) {
+        error = "cannot sync the directory of " + path;
+        return false;
+    }
+    return true;
+}
+
+// Check a snapshot header read from a file of fileSize bytes
+inline bool validSnapshotHeader(const SnapshotHeader& header, uint64_t fileSize, std::string& error) {
+    if (std::memcmp(header.magic, snapshotMagic, sizeof header.magic) != 0) {
+        error = "not an inventory snapshot";
+        return false;
+    }
+    if (header.byteOrderMark != snapshotByteOrderMark) {
+        error = "snapshot was written on a machine with a different byte order";
+        return false;
+    }
+    if (header.version < 1 || header.version > snapshotVersion) {
+        error = "unsupported snapshot version";
+        return false;
+    }
+    if (header.recordsOffset < sizeof(SnapshotHeader) || header.recordsOffset > fileSize ||
+        header.itemCount > (fileSize - header.recordsOffset) / sizeof(SnapshotRecord) ||
+        header.stringsOffset < header.recordsOffset + header.itemCount * sizeof(SnapshotRecord) ||
+        header.stringsOffset > fileSize || header.stringsSize > fileSize - header.stringsOffset) {
+        error = "snapshot is truncated or corrupt";
+        return false;
+    }
+    return true;
+}
+
+// Check the index sections of a version 2 snapshot
+inline bool validSnapshotIndexHeader(const SnapshotHeader& header, const SnapshotIndexHeader& index, uint64_t fileSize,
+                                     std::string& error) {
+    uint64_t arrayBytes = header.itemCount * sizeof(uint32_t);
+    uint64_t categoryTotal = 0;
+    for (uint64_t size : index.categorySizes) categoryTotal += size;
+    bool ok = index.hashBuckets != 0 && (index.hashBuckets & (index.hashBuckets - 1)) == 0 &&
+              index.hashBuckets > header.itemCount && index.hashBuckets <= fileSize / sizeof(uint32_t) &&
+              index.hashOffset % sizeof(uint32_t) == 0 && index.hashOffset <= fileSize &&
+              index.hashBuckets * sizeof(uint32_t) <= fileSize - index.hashOffset && categoryTotal == header.itemCount;
+    const uint64_t arrays[] = {index.categoryOffset, index.quantityOrderOffset, index.priceOrderOffset};
+    for (uint64_t offset : arrays) {
+        ok = ok && offset % sizeof(uint32_t) == 0 && offset <= fileSize && arrayBytes <= fileSize - offset;
+    }
+    if (!ok) error = "snapshot indexes are truncated or corrupt";
+    return ok;
+}
+
+// Check that a record's text lies inside the string table and its ID and
+// fields are valid, by the same rules as the CSV importer (a NaN price would
+// also break the ordering of the price index)
+inline bool validSnapshotRecord(const SnapshotRecord& record, const char* strings, uint64_t stringsSize) {
+    uint64_t length = static_cast<uint64_t>(record.idLength) + record.nameLength;
+    return record.textOffset <= stringsSize && length <= stringsSize - record.textOffset &&
+           validItemId(strings + record.textOffset, record.idLength) && record.category >= 1 &&
+           record.category <= categoryCount && record.quantity >= 0 && record.price > 0 &&
+           std::isfinite(record.price);
+}
+
+// Replace the inventory's items with the contents of a snapshot
+inline bool loadSnapshot(Inventory& inventory, const std::string& path, std::string& error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    SnapshotHeader header;
+    uint64_t size = 0;
+    if (!readBytes(file, &header, sizeof header) || !fileSize(file, size)) {
+        fclose(file);
+        error = "cannot read " + path;
+        return false;
+    }
+    if (!validSnapshotHeader(header, size, error)) {
+        fclose(file);
+        return false;
+    }
+
+    std::vector<SnapshotRecord> records(header.itemCount);
+    std::vector<char> strings(header.stringsSize);
+    bool ok = seekFile(file, header.recordsOffset) && readBytes(file, records.data(), records.size() * sizeof(SnapshotRecord)) &&
+         seekFile(file, header.stringsOffset) && readBytes(file, strings.data(), strings.size());
+    fclose(file);
+    if (!ok) {
+        error = "cannot read " + path;
+        return false;
+    }
+
+    for (const SnapshotRecord& record : records) {
+        if (!validSnapshotRecord(record, strings.data(), header.stringsSize)) {
+            error = "snapshot is truncated or corrupt";
+            return false;
+        }
+    }
+
+    // The current items are only dropped once the snapshot has been read and
+    // checked; a duplicate ID (only possible in a damaged file) leaves the
+    // inventory empty.
+    std::vector<Item> batch;
+    batch.reserve(records.size());
+    for (const SnapshotRecord& record : records) {
+        const char* text = strings.data() + record.textOffset;
+        batch.emplace_back(TextView(text, record.idLength), TextView(text + record.idLength, record.nameLength),
+                           record.quantity, record.price, static_cast<Category>(record.category));
+    }
+    inventory.clear();
+    if (inventory.insertItems(batch) != batch.size()) {
+        inventory.clear();
+        error = "snapshot contains a duplicate item ID";
+        return false;
+    }
+    return true;
+}
+
+#endif
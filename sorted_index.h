@@ -0,0 +1,195 @@
+#ifndef SORTED_INDEX_H
+#define SORTED_INDEX_H
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "item_store.h"
+
+// Ordered index of items by one numeric field (quantity or price).
+//
+// Entries are ordered by value, then by item slot, so every entry is unique
+// and items with equal values keep a stable order (roughly the order they
+// were added in). Comparisons never touch the items themselves. The
+// inventory keeps the index up to date on every add, update and remove;
+// sorted listings and top-N queries walk it instead of sorting.
+//
+// Storage is a flat B+tree leaf level: a vector of sorted chunks of at most
+// maxChunk entries. Lookups binary-search the chunks by their last entry and
+// then the chunk itself; inserts and erases shift at most one chunk. That
+// keeps the index at about the size of its entries, makes walks sequential in
+// memory, and lets a bulk load build the chunks straight from sorted input.
+//
+// The value is stored in the entry, so an entry must be erased with the
+// value it was inserted with, before the item's field changes.
+template <typename T>
+class SortedIndex {
+public:
+    struct Entry {
+        T value;
+        ItemHandle handle;
+
+        bool operator<(const Entry& other) const {
+            if (value < other.value) return true;
+            if (other.value < value) return false;
+            return handle.slot < other.handle.slot;
+        }
+    };
+
+private:
+    typedef std::vector<Entry> Chunk;
+
+    static const size_t maxChunk = 256;
+
+    std::vector<Chunk> chunks;
+    size_t count = 0;
+
+    // First chunk whose last entry is not less than entry; the last chunk if
+    // entry is greater than everything
+    size_t chunkFor(const Entry& entry) const {
+        size_t low = 0, high = chunks.size();
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (chunks[middle].back() < entry) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low < chunks.size() ? low : chunks.size() - 1;
+    }
+
+    // Rebuild the chunks from a sorted sequence, half-full so later inserts
+    // rarely split
+    void build(const std::vector<Entry>& sorted) {
+        chunks.clear();
+        const size_t fill = maxChunk / 2;
+        for (size_t i = 0; i < sorted.size(); i += fill) {
+            size_t end = std::min(sorted.size(), i + fill);
+            chunks.emplace_back(sorted.begin() + i, sorted.begin() + end);
+        }
+        count = sorted.size();
+    }
+
+public:
+    class const_iterator {
+    private:
+        const std::vector<Chunk>* chunks = nullptr;
+        size_t chunk = 0;
+        size_t position = 0;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef Entry value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Entry* pointer;
+        typedef const Entry& reference;
+
+        const_iterator() = default;
+        const_iterator(const std::vector<Chunk>* chunks, size_t chunk, size_t position)
+                : chunks(chunks), chunk(chunk), position(position) {}
+
+        reference operator*() const { return (*chunks)[chunk][position]; }
+        pointer operator->() const { return &(*chunks)[chunk][position]; }
+
+        const_iterator& operator++() {
+            if (++position == (*chunks)[chunk].size()) {
+                ++chunk;
+                position = 0;
+            }
+            return *this;
+        }
+
+        const_iterator& operator--() {
+            if (position == 0) {
+                --chunk;
+                position = (*chunks)[chunk].size();
+            }
+            --position;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return chunk == other.chunk && position == other.position;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    void insert(T value, ItemHandle handle) {
+        Entry entry{value, handle};
+        if (chunks.empty()) {
+            chunks.emplace_back();
+            chunks.back().reserve(maxChunk);
+            chunks.back().push_back(entry);
+            ++count;
+            return;
+        }
+        size_t c = chunkFor(entry);
+        Chunk& chunk = chunks[c];
+        chunk.insert(std::upper_bound(chunk.begin(), chunk.end(), entry), entry);
+        ++count;
+
+        if (chunk.size() > maxChunk) {
+            Chunk upper(chunk.begin() + maxChunk / 2, chunk.end());
+            chunk.resize(maxChunk / 2);
+            chunks.insert(chunks.begin() + static_cast<std::ptrdiff_t>(c) + 1, std::move(upper));
+        }
+    }
+
+    void erase(T value, ItemHandle handle) {
+        if (chunks.empty()) return;
+        Entry entry{value, handle};
+        size_t c = chunkFor(entry);
+        Chunk& chunk = chunks[c];
+        typename Chunk::iterator it = std::lower_bound(chunk.begin(), chunk.end(), entry);
+        if (it == chunk.end() || entry < *it) return;
+        chunk.erase(it);
+        --count;
+        if (chunk.empty()) {
+            chunks.erase(chunks.begin() + static_cast<std::ptrdiff_t>(c));
+        }
+    }
+
+    // Insert many entries at once. Small batches go in one by one; larger
+    // ones are sorted and merged with the existing entries in a single pass.
+    void insertBatch(std::vector<Entry>& batch) {
+        if (batch.size() < count / 16) {
+            for (const Entry& entry : batch) insert(entry.value, entry.handle);
+            return;
+        }
+        std::sort(batch.begin(), batch.end());
+        std::vector<Entry> merged;
+        merged.reserve(count + batch.size());
+        std::merge(begin(), end(), batch.begin(), batch.end(), std::back_inserter(merged));
+        build(merged);
+    }
+
+    void clear() {
+        chunks.clear();
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+    const_iterator begin() const { return const_iterator(&chunks, 0, 0); }
+    const_iterator end() const { return const_iterator(&chunks, chunks.size(), 0); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+};
+
+#endif
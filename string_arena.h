@@ -0,0 +1,169 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Shared storage for item text (IDs and names).
+//
+// Text is bump-allocated from 64 KiB chunks, so storing an item's text is
+// a pointer bump and a copy, not a heap allocation of its own. Each thread
+// allocates from a chunk of its own, so the CSV importer's workers never
+// contend. A chunk counts its live allocations, plus one while a thread is
+// still allocating from it, and is freed when the count drops to zero:
+// removed items give their chunk's memory back once its neighbours are
+// gone too. Chunks are aligned to their size, so the chunk of any text is
+// found by masking the pointer; text needs no header of its own. Text too
+// long for a chunk gets a chunk to itself.
+//
+// Short text takes a block rounded up to 8 bytes, so an ItemStore can keep
+// the blocks of removed items and hand them to new items of the same block
+// size. Releasing the newest block of the thread's chunk, as a temporary
+// copy does, gives its space straight back.
+struct StringArenaStats {
+    size_t chunks = 0;
+    size_t bytes = 0; // reserved by chunks, including unused space
+};
+
+class StringArena {
+public:
+    static const size_t chunkSize = 64 << 10;
+
+private:
+    struct Chunk {
+        std::atomic<size_t> references;
+        size_t used; // bytes handed out; changed only by the owning thread
+        size_t size;
+    };
+
+    static const size_t headerSize = sizeof(Chunk);
+
+    // Drops the thread's reference to its current chunk when the thread ends
+    struct Owner {
+        Chunk* current = nullptr;
+
+        ~Owner() {
+            if (current != nullptr) unreference(current);
+        }
+    };
+
+    static Owner& owner() {
+        static thread_local Owner threadOwner;
+        return threadOwner;
+    }
+
+    static std::atomic<size_t>& chunkCount() {
+        static std::atomic<size_t> count(0);
+        return count;
+    }
+
+    static std::atomic<size_t>& reservedBytes() {
+        static std::atomic<size_t> bytes(0);
+        return bytes;
+    }
+
+    static Chunk* newChunk(size_t size) {
+        void* memory = nullptr;
+#ifdef _WIN32
+        memory = _aligned_malloc(size, chunkSize);
+#else
+        if (posix_memalign(&memory, chunkSize, size) != 0) memory = nullptr;
+#endif
+        if (memory == nullptr) std::abort();
+        Chunk* chunk = static_cast<Chunk*>(memory);
+        new (&chunk->references) std::atomic<size_t>(1);
+        chunk->used = headerSize;
+        chunk->size = size;
+        chunkCount().fetch_add(1, std::memory_order_relaxed);
+        reservedBytes().fetch_add(size, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    static Chunk* chunkOf(const char* text) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(text) & ~static_cast<uintptr_t>(chunkSize - 1);
+        return reinterpret_cast<Chunk*>(address);
+    }
+
+    static void unreference(Chunk* chunk) {
+        if (chunk->references.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        chunkCount().fetch_sub(1, std::memory_order_relaxed);
+        reservedBytes().fetch_sub(chunk->size, std::memory_order_relaxed);
+#ifdef _WIN32
+        _aligned_free(chunk);
+#else
+        std::free(chunk);
+#endif
+    }
+
+public:
+    // Bytes a block for length bytes of text takes
+    static size_t blockSize(size_t length) {
+        return length > chunkSize / 4 ? length : (length + 7) & ~static_cast<size_t>(7);
+    }
+
+    // Room for length bytes of text, or nullptr when length is 0. Every
+    // non-null result must be given back with release().
+    static char* allocate(size_t length) {
+        if (length == 0) return nullptr;
+        if (length > chunkSize / 4) {
+            // Long text: a chunk of its own, never shared
+            Chunk* chunk = newChunk(headerSize + length);
+            chunk->used = chunk->size;
+            return reinterpret_cast<char*>(chunk) + headerSize;
+        }
+        length = blockSize(length);
+        Owner& self = owner();
+        if (self.current == nullptr || self.current->used + length > self.current->size) {
+            if (self.current != nullptr) unreference(self.current);
+            self.current = newChunk(chunkSize);
+        }
+        Chunk* chunk = self.current;
+        char* text = reinterpret_cast<char*>(chunk) + chunk->used;
+        chunk->used += length;
+        chunk->references.fetch_add(1, std::memory_order_relaxed);
+        return text;
+    }
+
+    // Copy of length bytes at data; nullptr when length is 0
+    static char* copy(const char* data, size_t length) {
+        char* text = allocate(length);
+        if (length > 0) std::memcpy(text, data, length);
+        return text;
+    }
+
+    // Give back text from allocate(); may be called from any thread
+    static void release(const char* text) {
+        if (text == nullptr) return;
+        unreference(chunkOf(text));
+    }
+
+    // The same, given the length it was allocated with; the newest block of
+    // the calling thread's chunk is taken back for the next allocation
+    static void release(const char* text, size_t length) {
+        if (text == nullptr) return;
+        Chunk* chunk = chunkOf(text);
+        Owner& self = owner();
+        size_t size = blockSize(length);
+        if (chunk == self.current && text + size == reinterpret_cast<char*>(chunk) + chunk->used) {
+            chunk->used -= size;
+        }
+        unreference(chunk);
+    }
+
+    static StringArenaStats stats() {
+        StringArenaStats result;
+        result.chunks = chunkCount().load(std::memory_order_relaxed);
+        result.bytes = reservedBytes().load(std::memory_order_relaxed);
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef TABLE_WRITER_H
+#define TABLE_WRITER_H
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#include "number_parser.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Destination for rendered output
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+    virtual void write(const char* data, size_t size) = 0;
+    virtual void flush() {}
+};
+
+// Writes to a C stdio stream such as stdout
+class FileSink : public OutputSink {
+private:
+    FILE* file;
+
+public:
+    explicit FileSink(FILE* file) : file(file) {}
+
+    void write(const char* data, size_t size) override { fwrite(data, 1, size, file); }
+    void flush() override { fflush(file); }
+};
+
+// Writes to a C++ stream
+class StreamSink : public OutputSink {
+private:
+    std::ostream& stream;
+
+public:
+    explicit StreamSink(std::ostream& stream) : stream(stream) {}
+
+    void write(const char* data, size_t size) override { stream.write(data, static_cast<std::streamsize>(size)); }
+    void flush() override { stream.flush(); }
+};
+
+// Writes straight to a file descriptor, bypassing stdio buffering
+class DescriptorSink : public OutputSink {
+private:
+    int fd;
+    bool ok = true;
+
+public:
+    explicit DescriptorSink(int fd) : fd(fd) {}
+
+    void write(const char* data, size_t size) override {
+        while (ok && size > 0) {
+#ifdef _WIN32
+            int written = _write(fd, data, static_cast<unsigned>(size > (1u << 30) ? (1u << 30) : size));
+#else
+            ssize_t written = ::write(fd, data, size);
+#endif
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                ok = false;
+                break;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // False once a write has failed; later writes are dropped
+    bool good() const { return ok; }
+};
+
+// Renders fixed-width table rows into a reusable buffer.
+//
+// Cells are left-aligned and padded to their width, matching what
+// std::left << std::setw(n) produced (longer values are not truncated).
+// Numbers are formatted without iostreams. The buffer is handed to the sink
+// in blocks of about 64 KiB (or the given block size), and once more by
+// flush(), which callers invoke at the end of each table before writing
+// anything else to the same stream. The buffer is allocated on first use,
+// so a writer that never renders anything (such as those of a
+// ConcurrentInventory's shards) costs no memory.
+class TableWriter {
+private:
+    OutputSink* sink;
+    std::vector<char> buffer;
+    size_t blockSize;
+    size_t used = 0;
+    size_t rows = 0;
+
+    char* reserve(size_t size) {
+        if (buffer.empty() || used + size > buffer.size()) {
+            if (used > 0) {
+                sink->write(buffer.data(), used);
+                used = 0;
+            }
+            if (buffer.size() < blockSize) buffer.resize(blockSize);
+            if (size > buffer.size()) buffer.resize(size);
+        }
+        char* out = buffer.data() + used;
+        used += size;
+        return out;
+    }
+
+    void pad(size_t length, int width) {
+        if (static_cast<int>(length) < width) {
+            size_t spaces = static_cast<size_t>(width) - length;
+            std::memset(reserve(spaces), ' ', spaces);
+        }
+    }
+
+public:
+    explicit TableWriter(OutputSink& sink, size_t blockSize = 1 << 16) : sink(&sink), blockSize(blockSize) {}
+
+    ~TableWriter() { flush(); }
+
+    TableWriter(const TableWriter&) = delete;
+    TableWriter& operator=(const TableWriter&) = delete;
+
+    // Point the writer at another sink; pending output goes to the old one
+    void setSink(OutputSink& newSink) {
+        flush();
+        sink = &newSink;
+    }
+
+    void text(const char* data, size_t length) { std::memcpy(reserve(length), data, length); }
+    void text(const char* data) { text(data, std::strlen(data)); }
+
+    void cell(const char* data, size_t length, int width) {
+        text(data, length);
+        pad(length, width);
+    }
+
+    void cell(const char* data, int width) { cell(data, std::strlen(data), width); }
+
+    void cell(long long value, int width) {
+        char digits[24];
+        char* end = digits + sizeof digits;
+        char* p = end;
+        unsigned long long magnitude = value < 0 ? 0ull - static_cast<unsigned long long>(value)
+                                                 : static_cast<unsigned long long>(value);
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) *--p = '-';
+        cell(p, static_cast<size_t>(end - p), width);
+    }
+
+    void cell(int value, int width) { cell(static_cast<long long>(value), width); }
+
+    // Same digits as the default ostream format (%g, 6 significant digits)
+    void cell(double value, int width) {
+        char digits[32];
+        int length = snprintf(digits, sizeof digits, "%g", value);
+        cell(digits, static_cast<size_t>(length), width);
+    }
+
+    // A number with the fewest digits that parse back to the same double
+    void number(double value) {
+        // Most prices are a whole number of cents: find the fewest decimals
+        // d such that round(value * 10^d) / 10^d gives value back, which is
+        // exactly how parseDouble reads the digits printed for it
+        static const double scales[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+        for (int decimals = 0; decimals < 7; ++decimals) {
+            double scaled = value * scales[decimals];
+            if (!(std::fabs(scaled) < 9007199254740992.0)) break;
+            long long whole = std::llround(scaled);
+            if (static_cast<double>(whole) / scales[decimals] != value) continue;
+            if (whole < 0) {
+                text("-");
+                whole = -whole;
+            }
+            long long integer = whole / static_cast<long long>(scales[decimals]);
+            long long fraction = whole % static_cast<long long>(scales[decimals]);
+            cell(integer, 0);
+            if (decimals > 0) {
+                char digits[8];
+                digits[0] = '.';
+                for (int i = decimals; i > 0; --i, fraction /= 10) digits[i] = static_cast<char>('0' + fraction % 10);
+                text(digits, static_cast<size_t>(decimals) + 1);
+            }
+            return;
+        }
+
+        char digits[32];
+        int length = snprintf(digits, sizeof digits, "%.15g", value);
+        double parsed;
+        if (!parseDouble(digits, digits + length, parsed) || parsed != value) {
+            length = snprintf(digits, sizeof digits, "%.17g", value);
+        }
+        text(digits, static_cast<size_t>(length));
+    }
+
+    void endRow() {
+        *reserve(1) = '\n';
+        ++rows;
+    }
+
+    // Write a complete line, e.g. a separator
+    void line(const char* data) {
+        text(data);
+        *reserve(1) = '\n';
+    }
+
+    // Hand everything buffered to the sink and flush it
+    void flush() {
+        if (used > 0) {
+            sink->write(buffer.data(), used);
+            used = 0;
+        }
+        sink->flush();
+    }
+
+    // Number of rows written since the writer was created
+    size_t rowCount() const { return rows; }
+};
+
+#endif
@@ -0,0 +1,101 @@
+// A batch run whose journal commit fails must not acknowledge the changes.
+//
+// The journal is held back to one group, so nothing is committed until the
+// runner flushes its output. The file size limit (RLIMIT_FSIZE) is then set
+// just past the journal header, so that commit fails, and the test checks
+// that no "ok" reached the sink and that run() reports the failure. The
+// same commands with no limit are run first, to show they do succeed.
+//
+// usage: batch_journal_test [directory for its files]
+
+#include <csignal>
+#include <cstdio>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "batch_runner.h"
+#include "file_io.h"
+#include "journal.h"
+#include "table_writer.h"
+
+// Collects everything the runner hands over
+class CaptureSink : public OutputSink {
+public:
+    std::string text;
+
+    void write(const char* data, size_t size) override { text.append(data, size); }
+};
+
+static const char commands[] = "add A1 5 9.5 1 Shirt\nadd B2 3 20 2 Cable\nquantity A1 0\n";
+
+static void removeFiles(const std::string& dataPath) {
+    std::remove((dataPath + ".snap").c_str());
+    std::remove((dataPath + ".wal").c_str());
+    std::remove((dataPath + ".cmd").c_str());
+}
+
+// Run commands against a fresh journaled inventory at dataPath, with the
+// file size limit set to limit bytes (0 for none)
+static bool runBatch(const std::string& dataPath, rlim_t limit, CaptureSink& sink, bool& ran) {
+    removeFiles(dataPath);
+    FILE* input = fopen((dataPath + ".cmd").c_str(), "wb");
+    if (input == nullptr || !writeBytes(input, commands, sizeof commands - 1) || fclose(input) != 0) {
+        std::fprintf(stderr, "cannot write %s.cmd\n", dataPath.c_str());
+        return false;
+    }
+
+    Inventory inventory;
+    Journal journal;
+    std::string error;
+    if (!openJournaledInventory(inventory, dataPath, journal, error)) {
+        std::fprintf(stderr, "cannot open %s: %s\n", dataPath.c_str(), error.c_str());
+        return false;
+    }
+    journal.setGroupCommit(1 << 20, std::chrono::hours(1));
+
+    int fd = openInputFile(dataPath + ".cmd");
+    if (fd < 0) return false;
+    rlimit saved;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    if (limit > 0) {
+        rlimit lowered = saved;
+        lowered.rlim_cur = limit;
+        setrlimit(RLIMIT_FSIZE, &lowered);
+    }
+    BatchRunner runner(inventory, sink);
+    runner.setJournal(&journal, dataPath);
+    BatchReport report;
+    ran = runner.run(fd, report);
+    setrlimit(RLIMIT_FSIZE, &saved);
+    closeFile(fd);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string dataPath = std::string(argc > 1 ? argv[1] : ".") + "/batch_journal_test";
+    std::signal(SIGXFSZ, SIG_IGN); // over the limit, writes fail with EFBIG instead
+
+    CaptureSink committed;
+    bool ran = false;
+    if (!runBatch(dataPath, 0, committed, ran)) return 1;
+    if (!ran || committed.text != "ok\nok\nok\n") {
+        std::fprintf(stderr, "FAIL: a run with a working journal gave:\n%s", committed.text.c_str());
+        return 1;
+    }
+
+    CaptureSink failed;
+    if (!runBatch(dataPath, sizeof journalMagic + 16, failed, ran)) return 1;
+    removeFiles(dataPath);
+    if (ran) {
+        std::fprintf(stderr, "FAIL: run() succeeded although the journal commit failed\n");
+        return 1;
+    }
+    if (failed.text.find("ok") != std::string::npos) {
+        std::fprintf(stderr, "FAIL: changes were acknowledged although the journal commit failed:\n%s",
+                     failed.text.c_str());
+        return 1;
+    }
+    std::printf("no acknowledgment was sent for an uncommitted change\n");
+    return 0;
+}
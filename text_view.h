@@ -0,0 +1,48 @@
+#ifndef TEXT_VIEW_H
+#define TEXT_VIEW_H
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+// Read-only view of characters owned by someone else, like C++17's
+// std::string_view. Item getters return views of the item's text and
+// lookups take views, so reading an ID or looking one up copies nothing.
+// A std::string or a C string converts to a view implicitly; a view must
+// not outlive the text it points at.
+class TextView {
+private:
+    const char* text = nullptr;
+    size_t count = 0;
+
+public:
+    TextView() = default;
+    TextView(const char* data, size_t length) : text(data), count(length) {}
+    TextView(const char* data) : text(data), count(std::strlen(data)) {}
+    TextView(const std::string& data) : text(data.data()), count(data.length()) {}
+
+    const char* data() const { return text; }
+    size_t length() const { return count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    char operator[](size_t index) const { return text[index]; }
+    const char* begin() const { return text; }
+    const char* end() const { return text + count; }
+
+    // A copy that owns its text
+    std::string str() const { return std::string(text, count); }
+};
+
+inline bool operator==(TextView a, TextView b) {
+    return a.length() == b.length() && (a.empty() || std::memcmp(a.data(), b.data(), a.length()) == 0);
+}
+
+inline bool operator!=(TextView a, TextView b) { return !(a == b); }
+
+inline std::ostream& operator<<(std::ostream& out, TextView text) {
+    return out.write(text.data(), static_cast<std::streamsize>(text.length()));
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run numbered tasks.
+//
+// run(count, task) calls task(0) ... task(count - 1), each exactly once,
+// spread over the workers and the calling thread, and returns when all of
+// them are done. Tasks are handed out one at a time from a shared counter,
+// so uneven tasks balance out. Only one run() may be in progress at a time.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // The current run; changed under lock
+    const std::function<void(size_t)>* task = nullptr;
+    size_t taskCount = 0;
+    size_t generation = 0;
+    size_t finished = 0; // workers done with this generation
+    bool stopping = false;
+
+    std::atomic<size_t> next{0};
+
+    void drain(const std::function<void(size_t)>& current, size_t count) {
+        for (size_t i = next++; i < count; i = next++) current(i);
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> guard(lock);
+        size_t seen = 0;
+        while (true) {
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            const std::function<void(size_t)>* current = task;
+            size_t count = taskCount;
+            guard.unlock();
+            drain(*current, count);
+            guard.lock();
+            // run() waits for every worker, so none can still be draining
+            // when the next run resets the counter
+            if (++finished == workers.size()) done.notify_one();
+        }
+    }
+
+public:
+    // threads counts the calling thread; 0 uses every hardware thread
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 1; t < threads; ++t) workers.emplace_back([this] { work(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    // Threads that run tasks, including the caller of run()
+    unsigned size() const { return static_cast<unsigned>(workers.size() + 1); }
+
+    void run(size_t count, const std::function<void(size_t)>& body) {
+        if (workers.empty() || count <= 1) {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            task = &body;
+            taskCount = count;
+            finished = 0;
+            next = 0;
+            ++generation;
+        }
+        wake.notify_all();
+        drain(body, count);
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&] { return finished == workers.size(); });
+        task = nullptr;
+    }
+};
+
+#endif